@@ -52,6 +52,7 @@ static bool cmd_targets(target *t, int argc, char **argv);
 static bool cmd_morse(target *t, int argc, char **argv);
 static bool cmd_halt_timeout(target *t, int argc, const char **argv);
 static bool cmd_connect_srst(target *t, int argc, const char **argv);
+static bool cmd_frequency(target *t, int argc, const char **argv);
 static bool cmd_hard_srst(target *t, int argc, const char **argv);
 #ifdef PLATFORM_HAS_POWER_SWITCH
 static bool cmd_target_power(target *t, int argc, const char **argv);
@@ -67,12 +68,13 @@ const struct command_s cmd_list[] = {
 	{"version", (cmd_handler)cmd_version, "Display firmware version info"},
 	{"help", (cmd_handler)cmd_help, "Display help for monitor commands"},
 	{"jtag_scan", (cmd_handler)cmd_jtag_scan, "Scan JTAG chain for devices" },
-	{"swdp_scan", (cmd_handler)cmd_swdp_scan, "Scan SW-DP for devices" },
+	{"swdp_scan", (cmd_handler)cmd_swdp_scan, "Scan SW-DP for devices: [TARGETID]" },
 	{"targets", (cmd_handler)cmd_targets, "Display list of available targets" },
 	{"morse", (cmd_handler)cmd_morse, "Display morse error message" },
 	{"halt_timeout", (cmd_handler)cmd_halt_timeout, "Timeout (ms) to wait until Cortex-M is halted: (Default 2000)" },
 	{"connect_srst", (cmd_handler)cmd_connect_srst, "Configure connect under SRST: (enable|disable)" },
 	{"hard_srst", (cmd_handler)cmd_hard_srst, "Force a pulse on the hard SRST line - disconnects target" },
+	{"frequency", (cmd_handler)cmd_frequency, "Set max SWCLK/TCK frequency, tuned at the next scan with auto: (freq[k|M]|auto)" },
 #ifdef PLATFORM_HAS_POWER_SWITCH
 	{"tpwr", (cmd_handler)cmd_target_power, "Supplies power to the target: (enable|disable)"},
 #endif
@@ -90,6 +92,7 @@ const struct command_s cmd_list[] = {
 };
 
 bool connect_assert_srst;
+bool frequency_auto;
 #if defined(PLATFORM_HAS_DEBUG) && !defined(PC_HOSTED)
 bool debug_bmp;
 #endif
@@ -208,8 +211,9 @@ static bool cmd_jtag_scan(target *t, int argc, char **argv)
 bool cmd_swdp_scan(target *t, int argc, char **argv)
 {
 	(void)t;
-	(void)argc;
-	(void)argv;
+	volatile uint32_t targetid = 0;
+	if (argc > 1)
+		targetid = strtoul(argv[1], NULL, 0);
 	gdb_outf("Target voltage: %s\n", platform_target_voltage());
 
 	if(connect_assert_srst)
@@ -218,7 +222,7 @@ bool cmd_swdp_scan(target *t, int argc, char **argv)
 	int devs = -1;
 	volatile struct exception e;
 	TRY_CATCH (e, EXCEPTION_ALL) {
-		devs = adiv5_swdp_scan();
+		devs = adiv5_swdp_scan(targetid);
 	}
 	switch (e.type) {
 	case EXCEPTION_TIMEOUT:
@@ -290,6 +294,25 @@ bool parse_enable_or_disable(const char *s, bool *out) {
 	}
 }
 
+bool parse_frequency(const char *s, uint32_t *out)
+{
+	char *p;
+	uint32_t frequency = strtoul(s, &p, 0);
+	if (p == s)
+		return false;
+	if (*p == 'k') {
+		frequency *= 1000;
+		p++;
+	} else if (*p == 'M') {
+		frequency *= 1000 * 1000;
+		p++;
+	}
+	if (*p || !frequency)
+		return false;
+	*out = frequency;
+	return true;
+}
+
 static bool cmd_connect_srst(target *t, int argc, const char **argv)
 {
 	(void)t;
@@ -311,6 +334,40 @@ static bool cmd_connect_srst(target *t, int argc, const char **argv)
 	return true;
 }
 
+static bool cmd_frequency(target *t, int argc, const char **argv)
+{
+	(void)t;
+	if (argc == 2) {
+		if (!strcmp(argv[1], "auto")) {
+#if defined(PLATFORM_NO_FREQUENCY_AUTO)
+			gdb_outf("Frequency auto tuning not supported\n");
+			return true;
+#else
+			frequency_auto = true;
+#endif
+		} else {
+			uint32_t frequency;
+			if (!parse_frequency(argv[1], &frequency)) {
+				gdb_outf("Unrecognized frequency %s\n", argv[1]);
+				return true;
+			}
+			frequency_auto = false;
+			platform_max_frequency_set(frequency);
+		}
+	} else if (argc > 2) {
+		gdb_outf("Unrecognized command format\n");
+		return true;
+	}
+	uint32_t frequency = platform_max_frequency_get();
+	if (frequency)
+		gdb_outf("Max SWCLK/TCK frequency: %" PRIu32 " Hz%s\n", frequency,
+		         frequency_auto ? ", tuned at the next scan" : "");
+	else
+		gdb_outf("SWCLK/TCK frequency not known%s\n",
+		         frequency_auto ? ", tuned at the next scan" : "");
+	return true;
+}
+
 static bool cmd_halt_timeout(target *t, int argc, const char **argv)
 {
 	(void)t;
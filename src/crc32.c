@@ -20,6 +20,8 @@
 
 #include "general.h"
 #include "target.h"
+#include "target_internal.h"
+#include "crc32.h"
 
 #if !defined(STM32F0) && !defined(STM32F1) && !defined(STM32F2) && \
 	!defined(STM32F3) && !defined(STM32F4) && !defined(STM32F7) && \
@@ -97,14 +99,14 @@ static uint32_t crc32_calc(uint32_t crc, uint8_t data)
 	return (crc << 8) ^ crc32_table[((crc >> 24) ^ data) & 255];
 }
 
-uint32_t generic_crc32(target *t, uint32_t base, size_t len)
+uint32_t crc32_mem(crc32_read_fn read, void *priv, uint32_t base, size_t len)
 {
 	uint32_t crc = -1;
 	uint8_t bytes[128];
 
 	while (len) {
 		size_t read_len = MIN(sizeof(bytes), len);
-		target_mem_read(t, bytes, base, read_len);
+		read(priv, bytes, base, read_len);
 
 		for (unsigned i = 0; i < read_len; i++)
 			crc = crc32_calc(crc, bytes[i]);
@@ -116,7 +118,7 @@ uint32_t generic_crc32(target *t, uint32_t base, size_t len)
 }
 #else
 #include <libopencm3/stm32/crc.h>
-uint32_t generic_crc32(target *t, uint32_t base, size_t len)
+uint32_t crc32_mem(crc32_read_fn read, void *priv, uint32_t base, size_t len)
 {
 	uint8_t bytes[128];
 	uint32_t crc;
@@ -125,7 +127,7 @@ uint32_t generic_crc32(target *t, uint32_t base, size_t len)
 
 	while (len > 3) {
 		size_t read_len = MIN(sizeof(bytes), len) & ~3;
-		target_mem_read(t, bytes, base, read_len);
+		read(priv, bytes, base, read_len);
 
 		for (unsigned i = 0; i < read_len; i += 4)
 			CRC_DR = __builtin_bswap32(*(uint32_t*)(bytes+i));
@@ -136,7 +138,7 @@ uint32_t generic_crc32(target *t, uint32_t base, size_t len)
 
 	crc = CRC_DR;
 
-	target_mem_read(t, bytes, base, len);
+	read(priv, bytes, base, len);
 	uint8_t *data = bytes;
 	while (len--) {
 		crc ^= *data++ << 24;
@@ -151,3 +153,16 @@ uint32_t generic_crc32(target *t, uint32_t base, size_t len)
 }
 #endif
 
+static void crc32_target_read(void *priv, void *dest, uint32_t src, size_t len)
+{
+	target_mem_read(priv, dest, src, len);
+}
+
+uint32_t generic_crc32(target *t, uint32_t base, size_t len)
+{
+	/* Let the target run the CRC where the data is, if it can */
+	if (t->mem_crc32)
+		return t->mem_crc32(t, base, len);
+	return crc32_mem(crc32_target_read, t, base, len);
+}
+
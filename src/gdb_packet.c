@@ -41,14 +41,34 @@ int gdb_getpacket(char *packet, int size)
 	    /* Wait for packet start */
 		do {
 			/* Spin waiting for a start of packet character - either a gdb
-             * start ('$') or a BMP remote packet start ('!').
+             * start ('$') or a BMP remote packet start ('!' or the binary
+             * framed REMOTE_BIN_SOM).
 			 */
 			do {
 				packet[0] = gdb_if_getchar();
 				if (packet[0]==0x04) return 1;
-			} while ((packet[0] != '$') && (packet[0] != REMOTE_SOM));
+			} while ((packet[0] != '$') && (packet[0] != REMOTE_SOM)
 #ifndef OWN_HL
-			if (packet[0]==REMOTE_SOM) {
+					 && (packet[0] != REMOTE_BIN_SOM)
+#endif
+				);
+#ifndef OWN_HL
+			if (packet[0]==REMOTE_BIN_SOM) {
+				/* Binary framed remote control packet, no
+				 * character in it has any special meaning */
+				uint16_t len = gdb_if_getchar();
+				len |= gdb_if_getchar() << 8;
+				for (i = 0; i < len; i++) {
+					c = gdb_if_getchar();
+					if (i < size)
+						packet[i] = c;
+				}
+				if (len <= size)
+					remotePacketProcessBinary(len, (uint8_t *)packet);
+				else
+					remotePacketDropBinary();
+				packet[0] = REMOTE_BIN_SOM;
+			} else if (packet[0]==REMOTE_SOM) {
 				/* This is probably a remote control packet
 				 * - get and handle it */
 				i=0;
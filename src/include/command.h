@@ -35,5 +35,12 @@ int command_process(target *t, char *cmd);
  */
 bool parse_enable_or_disable(const char *s, bool *out);
 
+/*
+ * Parses a SWCLK/TCK frequency in Hz, optionally followed by a 'k' or
+ * 'M' multiplier. Returns false and leaves out untouched on a zero
+ * frequency or trailing characters.
+ */
+bool parse_frequency(const char *s, uint32_t *out);
+
 #endif
 
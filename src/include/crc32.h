@@ -21,6 +21,13 @@
 #ifndef __CRC32_H
 #define __CRC32_H
 
-uint32_t generic_crc32(target *t, uint32_t base, int len);
+#include "target.h"
+
+/* CRC-32 (polynomial 0x04C11DB7, MSB first, no final XOR) as used by
+ * GDB's qCRC, over memory read with the given function */
+typedef void (*crc32_read_fn)(void *priv, void *dest, uint32_t src, size_t len);
+uint32_t crc32_mem(crc32_read_fn read, void *priv, uint32_t base, size_t len);
+
+uint32_t generic_crc32(target *t, uint32_t base, size_t len);
 
 #endif
@@ -45,6 +45,20 @@ void jtagtap_tdi_seq(const uint8_t final_tms, const uint8_t *DI, int ticks);
  * - DO may be point to the same address as DI.
  */
 
+/* Deferred capture: DO of jtagtap_tdi_tdo_seq_defer() only becomes valid
+ * after jtagtap_sync(), so scans up to the sync can be sent to the TAP in
+ * one go. On platforms without PLATFORM_HAS_JTAGTAP_DEFER the capture is
+ * done at once.
+ */
+#if defined(PLATFORM_HAS_JTAGTAP_DEFER)
+void jtagtap_tdi_tdo_seq_defer(uint8_t *DO, const uint8_t final_tms, const uint8_t *DI, int ticks);
+void jtagtap_sync(void);
+#else
+#define jtagtap_tdi_tdo_seq_defer(DO, final_tms, DI, ticks)	\
+	jtagtap_tdi_tdo_seq(DO, final_tms, DI, ticks)
+#define jtagtap_sync()	do {} while (0)
+#endif
+
 /* generic soft reset: 1, 1, 1, 1, 1, 0 */
 #define jtagtap_soft_reset()	\
 	jtagtap_tms_seq(0x1F, 6)
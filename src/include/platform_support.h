@@ -44,5 +44,19 @@ bool platform_target_get_power(void);
 void platform_target_set_power(bool power);
 void platform_request_boot(void);
 
+/* Interface (SWCLK/TCK) clock in Hz. The platform runs at the fastest
+ * clock it can do up to frequency, platform_max_frequency_get() tells
+ * which. */
+void platform_max_frequency_set(uint32_t frequency);
+uint32_t platform_max_frequency_get(void);
+/* With frequency_auto set, scans raise the clock as long as the link
+ * reads back reliably, see platform_max_frequency_tune(). */
+extern bool frequency_auto;
+void platform_max_frequency_tune(bool (*link_ok)(void));
+/* Clock auto tuning starts from */
+#define FREQUENCY_AUTO_START 1000000
+/* Slowest clock the bit banged platforms run at */
+#define FREQUENCY_MIN 1000
+
 #endif
 
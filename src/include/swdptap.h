@@ -35,5 +35,16 @@ bool swdptap_seq_in_parity(uint32_t *data, int ticks);
 void swdptap_seq_out(uint32_t MS, int ticks);
 void swdptap_seq_out_parity(uint32_t MS, int ticks);
 
+/* Transfer level function, provided in adiv5_swdp.c from the low level
+   functions above. One SWD transfer: the request, the ACK and, with an
+   OK ACK, the data phase. *data holds the value to write or receives the
+   value read. Returns the ACK. Platforms defining
+   PLATFORM_HAS_SWDPTAP_TRANSFER first try platform_swdptap_transfer(),
+   which returns false when the transfer can not be done in one go. */
+#define SWDP_ACK_OK    0x01
+#define SWDP_ACK_WAIT  0x02
+#define SWDP_ACK_FAULT 0x04
+uint8_t swdptap_transfer(uint8_t request, uint32_t *data, bool *parity_error);
+
 #endif
 
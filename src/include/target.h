@@ -34,7 +34,7 @@ typedef struct target_s target;
 typedef uint32_t target_addr;
 struct target_controller;
 
-int adiv5_swdp_scan(void);
+int adiv5_swdp_scan(uint32_t targetid);
 int jtag_scan(const uint8_t *lrlens);
 
 bool target_foreach(void (*cb)(int i, target *t, void *context), void *context);
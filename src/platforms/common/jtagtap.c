@@ -58,8 +58,10 @@ inline uint8_t jtagtap_next(uint8_t dTMS, uint8_t dTDI)
 	gpio_set_val(TMS_PORT, TMS_PIN, dTMS);
 	gpio_set_val(TDI_PORT, TDI_PIN, dTDI);
 	gpio_set(TCK_PORT, TCK_PIN);
+	SWD_DELAY();
 	ret = gpio_get(TDO_PORT, TDO_PIN);
 	gpio_clear(TCK_PORT, TCK_PIN);
+	SWD_DELAY();
 
 	//DEBUG("jtagtap_next(TMS = %d, TDI = %d) = %d\n", dTMS, dTDI, ret);
 
@@ -73,10 +75,12 @@ void jtagtap_tms_seq(uint32_t MS, int ticks)
 	while(ticks) {
 		gpio_set_val(TMS_PORT, TMS_PIN, data);
 		gpio_set(TCK_PORT, TCK_PIN);
+		SWD_DELAY();
 		MS >>= 1;
 		data = MS & 1;
 		ticks--;
 		gpio_clear(TCK_PORT, TCK_PIN);
+		SWD_DELAY();
 	}
 }
 
@@ -89,6 +93,7 @@ jtagtap_tdi_tdo_seq(uint8_t *DO, const uint8_t final_tms, const uint8_t *DI, int
 	while(ticks > 1) {
 		gpio_set_val(TDI_PORT, TDI_PIN, *DI & index);
 		gpio_set(TCK_PORT, TCK_PIN);
+		SWD_DELAY();
 		if (gpio_get(TDO_PORT, TDO_PIN)) {
 			res |= index;
 		}
@@ -100,15 +105,18 @@ jtagtap_tdi_tdo_seq(uint8_t *DO, const uint8_t final_tms, const uint8_t *DI, int
 		}
 		ticks--;
 		gpio_clear(TCK_PORT, TCK_PIN);
+		SWD_DELAY();
 	}
 	gpio_set_val(TMS_PORT, TMS_PIN, final_tms);
 	gpio_set_val(TDI_PORT, TDI_PIN, *DI & index);
 	gpio_set(TCK_PORT, TCK_PIN);
+	SWD_DELAY();
 	if (gpio_get(TDO_PORT, TDO_PIN)) {
 		res |= index;
 	}
 	*DO = res;
 	gpio_clear(TCK_PORT, TCK_PIN);
+	SWD_DELAY();
 }
 
 void
@@ -119,10 +127,12 @@ jtagtap_tdi_seq(const uint8_t final_tms, const uint8_t *DI, int ticks)
 		gpio_set_val(TMS_PORT, TMS_PIN, ticks? 0 : final_tms);
 		gpio_set_val(TDI_PORT, TDI_PIN, *DI & index);
 		gpio_set(TCK_PORT, TCK_PIN);
+		SWD_DELAY();
 		if(!(index <<= 1)) {
 			index = 1;
 			DI++;
 		}
 		gpio_clear(TCK_PORT, TCK_PIN);
+		SWD_DELAY();
 	}
 }
@@ -49,7 +49,9 @@ static void swdptap_turnaround(int dir)
 		SWDIO_MODE_FLOAT();
 	gpio_set(SWCLK_PORT, SWCLK_PIN);
 	gpio_set(SWCLK_PORT, SWCLK_PIN);
+	SWD_DELAY();
 	gpio_clear(SWCLK_PORT, SWCLK_PIN);
+	SWD_DELAY();
 	if(dir == SWDIO_STATUS_DRIVE)
 		SWDIO_MODE_DRIVE();
 }
@@ -63,7 +65,9 @@ bool swdptap_bit_in(void)
 	ret = gpio_get(SWDIO_PORT, SWDIO_PIN);
 	gpio_set(SWCLK_PORT, SWCLK_PIN);
 	gpio_set(SWCLK_PORT, SWCLK_PIN);
+	SWD_DELAY();
 	gpio_clear(SWCLK_PORT, SWCLK_PIN);
+	SWD_DELAY();
 
 #ifdef DEBUG_SWD_BITS
 	DEBUG("%d", ret?1:0);
@@ -84,10 +88,12 @@ swdptap_seq_in(int ticks)
 		int res;
 		res = gpio_get(SWDIO_PORT, SWDIO_PIN);
 		gpio_set(SWCLK_PORT, SWCLK_PIN);
+		SWD_DELAY();
 		if (res)
 			ret |= index;
 		index <<= 1;
 		gpio_clear(SWCLK_PORT, SWCLK_PIN);
+		SWD_DELAY();
 	}
 
 #ifdef DEBUG_SWD_BITS
@@ -110,18 +116,22 @@ swdptap_seq_in_parity(uint32_t *ret, int ticks)
 	while (len--) {
 		bit = gpio_get(SWDIO_PORT, SWDIO_PIN);
 		gpio_set(SWCLK_PORT, SWCLK_PIN);
+		SWD_DELAY();
 		if (bit) {
 			res |= index;
 			parity ^= 1;
 		}
 		index <<= 1;
 		gpio_clear(SWCLK_PORT, SWCLK_PIN);
+		SWD_DELAY();
 	}
 	bit = gpio_get(SWDIO_PORT, SWDIO_PIN);
 	gpio_set(SWCLK_PORT, SWCLK_PIN);
+	SWD_DELAY();
 	if (bit)
 		parity ^= 1;
 	gpio_clear(SWCLK_PORT, SWCLK_PIN);
+	SWD_DELAY();
 #ifdef DEBUG_SWD_BITS
 	for (int i = 0; i < len; i++)
 		DEBUG("%d", (res & (1 << i)) ? 1 : 0);
@@ -140,9 +150,12 @@ void swdptap_bit_out(bool val)
 
 	gpio_set_val(SWDIO_PORT, SWDIO_PIN, val);
 	gpio_clear(SWCLK_PORT, SWCLK_PIN);
+	SWD_DELAY();
 	gpio_set(SWCLK_PORT, SWCLK_PIN);
 	gpio_set(SWCLK_PORT, SWCLK_PIN);
+	SWD_DELAY();
 	gpio_clear(SWCLK_PORT, SWCLK_PIN);
+	SWD_DELAY();
 }
 void
 swdptap_seq_out(uint32_t MS, int ticks)
@@ -159,7 +172,9 @@ swdptap_seq_out(uint32_t MS, int ticks)
 		data = MS & 1;
 		gpio_set(SWCLK_PORT, SWCLK_PIN);
 		gpio_set(SWCLK_PORT, SWCLK_PIN);
+		SWD_DELAY();
 		gpio_clear(SWCLK_PORT, SWCLK_PIN);
+		SWD_DELAY();
 	}
 }
 
@@ -179,12 +194,17 @@ swdptap_seq_out_parity(uint32_t MS, int ticks)
 		parity ^= MS;
 		MS >>= 1;
 		gpio_set(SWCLK_PORT, SWCLK_PIN);
+		SWD_DELAY();
 		data = MS & 1;
 		gpio_clear(SWCLK_PORT, SWCLK_PIN);
+		SWD_DELAY();
 	}
 	gpio_set_val(SWDIO_PORT, SWDIO_PIN, parity & 1);
 	gpio_clear(SWCLK_PORT, SWCLK_PIN);
+	SWD_DELAY();
 	gpio_set(SWCLK_PORT, SWCLK_PIN);
 	gpio_set(SWCLK_PORT, SWCLK_PIN);
+	SWD_DELAY();
 	gpio_clear(SWCLK_PORT, SWCLK_PIN);
+	SWD_DELAY();
 }
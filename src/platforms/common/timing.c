@@ -29,3 +29,62 @@ bool platform_timeout_is_expired(platform_timeout *t)
 	return platform_time_ms() > t->time;
 }
 
+/* Approximate CPU cycles of one bit of the bit banged SWD/JTAG loops,
+ * and added by each count of the two half clock delays. The actual
+ * clock varies a bit with the compiler and the bus. */
+#define SWD_CYCLES_BASE    22
+#define SWD_CYCLES_PER_CNT 10
+
+int32_t swd_delay_cnt = 0;
+
+void swd_delay_frequency_set(uint32_t cpu_frequency, uint32_t frequency)
+{
+	if (frequency < FREQUENCY_MIN)
+		frequency = FREQUENCY_MIN;
+	uint32_t divisor = cpu_frequency / frequency;
+
+	if (divisor <= SWD_CYCLES_BASE)
+		swd_delay_cnt = 0;
+	else
+		swd_delay_cnt = (divisor - SWD_CYCLES_BASE + SWD_CYCLES_PER_CNT - 1) /
+			SWD_CYCLES_PER_CNT;
+}
+
+uint32_t swd_delay_frequency_get(uint32_t cpu_frequency)
+{
+	return cpu_frequency /
+		(SWD_CYCLES_BASE + SWD_CYCLES_PER_CNT * swd_delay_cnt);
+}
+
+/* Raise the interface clock step by step as long as link_ok() passes
+ * every time, then back off to the last clock that passed. link_ok()
+ * reads back a known value, e.g. the IDCODE, and fails on mismatches
+ * and bad parity. It is called once more at the end to resynchronise
+ * the link. */
+void platform_max_frequency_tune(bool (*link_ok)(void))
+{
+	static const uint32_t steps[] = {
+		1000000, 2000000, 4000000, 6000000, 8000000, 12000000,
+		16000000, 24000000, 30000000, 48000000,
+	};
+	uint32_t good = platform_max_frequency_get();
+
+	for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+		if (steps[i] <= good)
+			continue;
+		platform_max_frequency_set(steps[i]);
+		uint32_t frequency = platform_max_frequency_get();
+		if (frequency <= good)
+			continue;
+		bool ok = true;
+		for (int j = 0; ok && (j < 16); j++)
+			ok = link_ok();
+		if (!ok)
+			break;
+		good = frequency;
+	}
+	platform_max_frequency_set(good);
+	link_ok();
+	DEBUG("Interface clock tuned to %" PRIu32 " Hz\n", good);
+}
+
@@ -26,5 +26,18 @@ struct platform_timeout {
 
 uint32_t platform_time_ms(void);
 
+/* Delay loop count per half clock of the bit banged SWD/JTAG ports.
+ * A count of 0 costs only the test, to keep the full speed clock. */
+extern int32_t swd_delay_cnt;
+/* Set swd_delay_cnt for a clock of at most frequency and return the
+ * clock it gives, for a CPU running at cpu_frequency */
+void swd_delay_frequency_set(uint32_t cpu_frequency, uint32_t frequency);
+uint32_t swd_delay_frequency_get(uint32_t cpu_frequency);
+#define SWD_DELAY() \
+	do { \
+		if (swd_delay_cnt) \
+			for (volatile int32_t cnt = swd_delay_cnt; cnt > 0; cnt--); \
+	} while (0)
+
 #endif /* __TIMING_H */
 
@@ -48,6 +48,16 @@ uint32_t platform_time_ms(void)
 	return time_ms;
 }
 
+void platform_max_frequency_set(uint32_t frequency)
+{
+	swd_delay_frequency_set(rcc_get_system_clock_frequency(), frequency);
+}
+
+uint32_t platform_max_frequency_get(void)
+{
+	return swd_delay_frequency_get(rcc_get_system_clock_frequency());
+}
+
 void
 platform_init(void)
 {
@@ -33,9 +33,25 @@
 #include "general.h"
 #include "jtagtap.h"
 
+/* Scans with TDO captures still to be fetched, see jtagtap_sync() */
+#define SCANQ_SIZE 64
+#define SCANQ_BYTES 1024
+static struct {
+	uint8_t *DO;
+	uint8_t *raw;
+	int rsize;
+	int rticks;
+	bool final_tms;
+} scanq[SCANQ_SIZE];
+static int scanq_count;
+static int scanq_bytes;
+static uint8_t scanq_raw[SCANQ_BYTES];
+
 int jtagtap_init(void)
 {
 	assert(ftdic != NULL);
+	/* Writes still in flight would race with the purge */
+	platform_buffer_sync();
 	int err = ftdi_usb_purge_buffers(ftdic);
 	if (err != 0) {
 		fprintf(stderr, "ftdi_usb_purge_buffer: %d: %s\n",
@@ -56,13 +72,14 @@ int jtagtap_init(void)
 			err, ftdi_get_error_string(ftdic));
 		return -1;;
 	}
-	uint8_t ftdi_init[9] = {TCK_DIVISOR, 0x00, 0x00, SET_BITS_LOW, 0,0,
+	platform_tck_set(6000000);
+	uint8_t ftdi_init[6] = {SET_BITS_LOW, 0,0,
 				SET_BITS_HIGH, 0,0};
-	ftdi_init[4]= active_cable->dbus_data;
-	ftdi_init[5]= active_cable->dbus_ddr;
-	ftdi_init[7]= active_cable->cbus_data;
-	ftdi_init[8]= active_cable->cbus_ddr;
-	platform_buffer_write(ftdi_init, 9);
+	ftdi_init[1]= active_cable->dbus_data;
+	ftdi_init[2]= active_cable->dbus_ddr;
+	ftdi_init[4]= active_cable->cbus_data;
+	ftdi_init[5]= active_cable->cbus_ddr;
+	platform_buffer_write(ftdi_init, 6);
 	platform_buffer_flush();
 
 	/* Go to JTAG mode for SWJ-DP */
@@ -92,14 +109,56 @@ jtagtap_tms_seq(uint32_t MS, int ticks)
 	}
 }
 
+/* Move the captured bytes of a scan into place. Remaining bits of the
+ * byte and the final TMS bit come back in the top of their bytes. */
+static void jtagtap_tdo_fixup(uint8_t *DO, const uint8_t *tmp, int rsize,
+                              int rticks, bool final_tms)
+{
+	int index = 0;
+
+	if(final_tms) rsize--;
+
+	while(rsize--) {
+		/*if(rsize) printf("%02X ", tmp[index]);*/
+		*DO++ = tmp[index++];
+	}
+	if (rticks == 0)
+		*DO++ = 0;
+	if(final_tms) {
+		rticks++;
+		*(--DO) >>= 1;
+		*DO |= tmp[index] & 0x80;
+	} else DO--;
+	if(rticks) {
+		*DO >>= (8-rticks);
+	}
+	/*printf("%02X\n", *DO);*/
+}
+
+void jtagtap_sync(void)
+{
+	platform_buffer_sync();
+	for (int i = 0; i < scanq_count; i++)
+		jtagtap_tdo_fixup(scanq[i].DO, scanq[i].raw, scanq[i].rsize,
+		                  scanq[i].rticks, scanq[i].final_tms);
+	scanq_count = 0;
+	scanq_bytes = 0;
+}
+
 void
-jtagtap_tdi_tdo_seq(uint8_t *DO, const uint8_t final_tms, const uint8_t *DI, int ticks)
+jtagtap_tdi_tdo_seq_defer(uint8_t *DO, const uint8_t final_tms, const uint8_t *DI, int ticks)
 {
 	int rsize, rticks;
 
 	if(!ticks) return;
 	if (!DI && !DO) return;
 
+	/* Worst case, a partial byte and the final TMS bit on top */
+	int max_rsize = ticks / 8 + 2;
+	if (DO && ((scanq_count == SCANQ_SIZE) ||
+	           (scanq_bytes + max_rsize > SCANQ_BYTES)))
+		jtagtap_sync();
+
 //	printf("ticks: %d\n", ticks);
 	if(final_tms) ticks--;
 	rticks = ticks & 7;
@@ -133,28 +192,30 @@ jtagtap_tdi_tdo_seq(uint8_t *DO, const uint8_t final_tms, const uint8_t *DI, int
 			data[index++] = (DI[ticks]) >> rticks?0x81 : 0x01;
 		platform_buffer_write(data, index);
 	}
-	if (DO) {
-		int index = 0;
-		uint8_t *tmp = alloca(ticks);
+	if (!DO)
+		return;
+	if (max_rsize > SCANQ_BYTES) {
+		uint8_t *tmp = alloca(rsize);
 		platform_buffer_read(tmp, rsize);
-		if(final_tms) rsize--;
-
-		while(rsize--) {
-			/*if(rsize) printf("%02X ", tmp[index]);*/
-			*DO++ = tmp[index++];
-		}
-		if (rticks == 0)
-			*DO++ = 0;
-		if(final_tms) {
-			rticks++;
-			*(--DO) >>= 1;
-			*DO |= tmp[index] & 0x80;
-		} else DO--;
-		if(rticks) {
-			*DO >>= (8-rticks);
-		}
-		/*printf("%02X\n", *DO);*/
+		jtagtap_tdo_fixup(DO, tmp, rsize, rticks, final_tms);
+		return;
 	}
+	scanq[scanq_count].DO = DO;
+	scanq[scanq_count].raw = scanq_raw + scanq_bytes;
+	scanq[scanq_count].rsize = rsize;
+	scanq[scanq_count].rticks = rticks;
+	scanq[scanq_count].final_tms = final_tms;
+	platform_buffer_read_queue(scanq_raw + scanq_bytes, rsize);
+	scanq_count++;
+	scanq_bytes += rsize;
+}
+
+void
+jtagtap_tdi_tdo_seq(uint8_t *DO, const uint8_t final_tms, const uint8_t *DI, int ticks)
+{
+	jtagtap_tdi_tdo_seq_defer(DO, final_tms, DI, ticks);
+	if (DO)
+		jtagtap_sync();
 }
 
 void jtagtap_tdi_seq(const uint8_t final_tms, const uint8_t *DI, int ticks)
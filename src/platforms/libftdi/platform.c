@@ -31,9 +31,31 @@ struct ftdi_context *ftdic;
 #include "cl_utils.h"
 
 #define BUF_SIZE 4096
-static uint8_t outbuf[BUF_SIZE];
+/* Writes are submitted asynchronously from a ring of BUF_COUNT buffers,
+ * so USB transfers overlap with filling the next buffer. */
+#define BUF_COUNT 4
+static uint8_t outbuf[BUF_COUNT][BUF_SIZE];
+static struct ftdi_transfer_control *outtc[BUF_COUNT];
+static int outidx;
 static uint16_t bufptr = 0;
 
+/* Reads queued by platform_buffer_read_queue(), fetched with one
+ * read transfer when a result is needed. */
+#define READQ_SIZE 64
+static struct {
+	uint8_t *data;
+	int size;
+} readq[READQ_SIZE];
+static int readq_count;
+static int readq_bytes;
+static uint8_t inbuf[BUF_SIZE];
+
+/* SWCLK/TCK frequency asked for, 0 for the default of the tap */
+static uint32_t max_frequency;
+/* Default of the tap initialised last, 0 before */
+static uint32_t tck_default;
+static uint32_t tck_frequency;
+
 cable_desc_t *active_cable;
 
 cable_desc_t cable_desc[] = {
@@ -86,6 +108,7 @@ cable_desc_t cable_desc[] = {
 		.bitbang_tms_in_port_cmd = GET_BITS_LOW,
 		.bitbang_tms_in_pin = MPSSE_TDO, /* keep bit 5 low*/
 		.bitbang_swd_dbus_read_data = 0x02,
+		.mpsse_swd_read = true,
 		.name = "ftdiswd"
 	},
 	{
@@ -208,6 +231,7 @@ void platform_init(int argc, char **argv)
 	       "<http://gnu.org/licenses/gpl.html>\n\n");
 
 	if(ftdic) {
+		platform_buffer_sync();
 		ftdi_usb_close(ftdic);
 		ftdi_free(ftdic);
 		ftdic = NULL;
@@ -245,8 +269,12 @@ void platform_init(int argc, char **argv)
 			err, ftdi_get_error_string(ftdic));
 		goto error_2;
 	}
+	if (cl_opts.opt_max_frequency)
+		platform_max_frequency_set(cl_opts.opt_max_frequency);
 	if (cl_opts.opt_mode != BMP_MODE_DEBUG) {
 		ret = cl_execute(&cl_opts);
+		/* Send what is left and complete the writes in flight */
+		platform_buffer_sync();
 	} else {
 		assert(gdb_if_init() == 0);
 		return;
@@ -266,30 +294,154 @@ void platform_srst_set_val(bool assert)
 
 bool platform_srst_get_val(void) { return false; }
 
+static void platform_buffer_write_done(int index)
+{
+	if (!outtc[index])
+		return;
+	int res = ftdi_transfer_data_done(outtc[index]);
+	outtc[index] = NULL;
+	if (res < 0) {
+		fprintf(stderr, "ftdi write: %d: %s\n",
+			res, ftdi_get_error_string(ftdic));
+		exit(-1);
+	}
+}
+
+/* Fetch all queued reads. The read transfer is submitted before the
+ * writes are flushed: the FTDI stops processing commands while its
+ * read FIFO is full, so waiting for a write first could dead lock.
+ * The current buffer is always free, there is room for SEND_IMMEDIATE. */
+static void platform_buffer_read_resolve(void)
+{
+	int count = readq_count;
+	int size = readq_bytes;
+	uint8_t *data = (count == 1) ? readq[0].data : inbuf;
+
+	if (!count)
+		return;
+	readq_count = 0;
+	readq_bytes = 0;
+	struct ftdi_transfer_control *tc =
+		ftdi_read_data_submit(ftdic, data, size);
+	if (!tc) {
+		fprintf(stderr, "ftdi_read_data_submit: %s\n",
+			ftdi_get_error_string(ftdic));
+		exit(-1);
+	}
+	outbuf[outidx][bufptr++] = SEND_IMMEDIATE;
+	platform_buffer_flush();
+	int res = ftdi_transfer_data_done(tc);
+	if (res != size) {
+		fprintf(stderr, "ftdi read: %d of %d bytes: %s\n",
+			res, size, ftdi_get_error_string(ftdic));
+		exit(-1);
+	}
+	if (count == 1)
+		return;
+	for (int i = 0; i < count; i++) {
+		memcpy(readq[i].data, data, readq[i].size);
+		data += readq[i].size;
+	}
+}
+
 void platform_buffer_flush(void)
 {
-	assert(ftdi_write_data(ftdic, outbuf, bufptr) == bufptr);
-//	printf("FT2232 platform_buffer flush: %d bytes\n", bufptr);
+	if (readq_count && outtc[(outidx + 1) % BUF_COUNT]) {
+		/* The next buffer is still in flight, queued reads must
+		 * be on their way before waiting for it, see above.
+		 * Resolving them flushes too.*/
+		platform_buffer_read_resolve();
+		return;
+	}
+	if (!bufptr)
+		return;
+	outtc[outidx] = ftdi_write_data_submit(ftdic, outbuf[outidx], bufptr);
+	if (!outtc[outidx]) {
+		fprintf(stderr, "ftdi_write_data_submit: %s\n",
+			ftdi_get_error_string(ftdic));
+		exit(-1);
+	}
+	outidx = (outidx + 1) % BUF_COUNT;
 	bufptr = 0;
+	platform_buffer_write_done(outidx);
+}
+
+void platform_buffer_sync(void)
+{
+	platform_buffer_read_resolve();
+	platform_buffer_flush();
+	for (int i = 0; i < BUF_COUNT; i++)
+		platform_buffer_write_done(i);
 }
 
 int platform_buffer_write(const uint8_t *data, int size)
 {
 	if((bufptr + size) / BUF_SIZE > 0) platform_buffer_flush();
-	memcpy(outbuf + bufptr, data, size);
+	memcpy(outbuf[outidx] + bufptr, data, size);
 	bufptr += size;
 	return size;
 }
 
+int platform_buffer_read_queue(uint8_t *data, int size)
+{
+	if ((readq_count == READQ_SIZE) || (readq_bytes + size > BUF_SIZE))
+		platform_buffer_read_resolve();
+	readq[readq_count].data = data;
+	readq[readq_count].size = size;
+	readq_count++;
+	readq_bytes += size;
+	/* Larger reads go directly to their destination */
+	if (size > BUF_SIZE)
+		platform_buffer_read_resolve();
+	return size;
+}
+
 int platform_buffer_read(uint8_t *data, int size)
 {
-	int index = 0;
-	outbuf[bufptr++] = SEND_IMMEDIATE;
-	platform_buffer_flush();
-	while((index += ftdi_read_data(ftdic, data + index, size-index)) != size);
+	platform_buffer_read_queue(data, size);
+	platform_buffer_read_resolve();
 	return size;
 }
 
+/* Set TCK to max_frequency, or to default_frequency if none was asked
+ * for. H type chips derive TCK from 60 MHz instead of 12 MHz once the
+ * divide by 5 is switched off. */
+void platform_tck_set(uint32_t default_frequency)
+{
+	bool high_speed = (ftdic->type == TYPE_2232H) ||
+		(ftdic->type == TYPE_4232H) || (ftdic->type == TYPE_232H);
+	uint32_t base = high_speed ? 30000000 : 6000000;
+	uint32_t frequency = max_frequency ? max_frequency : default_frequency;
+	uint32_t divisor = 0;
+	uint8_t cmd[4];
+	int index = 0;
+
+	if (frequency < base)
+		divisor = (base + frequency - 1) / frequency - 1;
+	if (divisor > 0xffff)
+		divisor = 0xffff;
+	if (high_speed)
+		cmd[index++] = DIS_DIV_5;
+	cmd[index++] = TCK_DIVISOR;
+	cmd[index++] = divisor & 0xff;
+	cmd[index++] = divisor >> 8;
+	platform_buffer_write(cmd, index);
+	tck_default = default_frequency;
+	tck_frequency = base / (divisor + 1);
+}
+
+void platform_max_frequency_set(uint32_t frequency)
+{
+	max_frequency = frequency;
+	if (tck_default)
+		platform_tck_set(tck_default);
+}
+
+uint32_t platform_max_frequency_get(void)
+{
+	return tck_frequency;
+}
+
 const char *platform_target_voltage(void)
 {
 	return "not supported";
@@ -37,6 +37,7 @@
 #define FT2232_PID	0x6010
 
 #define PLATFORM_HAS_DEBUG
+#define PLATFORM_HAS_JTAGTAP_DEFER
 
 #define PLATFORM_IDENT "FTDI/MPSSE"
 #define SET_RUN_STATE(state)
@@ -48,6 +49,12 @@ extern struct ftdi_context *ftdic;
 void platform_buffer_flush(void);
 int platform_buffer_write(const uint8_t *data, int size);
 int platform_buffer_read(uint8_t *data, int size);
+/* Queue a read of size bytes into data, which stays undefined until the
+ * next platform_buffer_read() or platform_buffer_sync(). */
+int platform_buffer_read_queue(uint8_t *data, int size);
+/* Fetch queued reads and wait for all writes to complete */
+void platform_buffer_sync(void);
+void platform_tck_set(uint32_t default_frequency);
 
 typedef struct cable_desc_s {
 	int vendor;
@@ -62,6 +69,9 @@ typedef struct cable_desc_s {
 	uint8_t bitbang_swd_dbus_read_data;
 	/* bitbang_swd_dbus_read_data is same as dbus_data,
 	 * as long as CBUS is not involved.*/
+	/* SWDIO reads back on TDO, so SWD reads are clocked in by the
+	 * MPSSE instead of sampling the pin once per bit. */
+	bool mpsse_swd_read;
 	char *description;
 	char * name;
 }cable_desc_t;
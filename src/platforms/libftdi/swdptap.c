@@ -41,6 +41,8 @@ int swdptap_init(void)
 		DEBUG("SWD not possible or missing item in cable description.\n");
 		return -1;
 	}
+	/* Writes still in flight would race with the purge */
+	platform_buffer_sync();
 	int err = ftdi_usb_purge_buffers(ftdic);
 	if (err != 0) {
 		fprintf(stderr, "ftdi_usb_purge_buffer: %d: %s\n",
@@ -61,13 +63,14 @@ int swdptap_init(void)
 			err, ftdi_get_error_string(ftdic));
 		return -1;;
 	}
-	uint8_t ftdi_init[9] = {TCK_DIVISOR, 0x01, 0x00, SET_BITS_LOW, 0,0,
+	platform_tck_set(3000000);
+	uint8_t ftdi_init[6] = {SET_BITS_LOW, 0,0,
 				SET_BITS_HIGH, 0,0};
-	ftdi_init[4]=  active_cable->dbus_data |  MPSSE_MASK;
-	ftdi_init[5]= active_cable->dbus_ddr   & ~MPSSE_TD_MASK;
-	ftdi_init[7]= active_cable->cbus_data;
-	ftdi_init[8]= active_cable->cbus_ddr;
-	platform_buffer_write(ftdi_init, 9);
+	ftdi_init[1]=  active_cable->dbus_data |  MPSSE_MASK;
+	ftdi_init[2]= active_cable->dbus_ddr   & ~MPSSE_TD_MASK;
+	ftdi_init[4]= active_cable->cbus_data;
+	ftdi_init[5]= active_cable->cbus_ddr;
+	platform_buffer_write(ftdi_init, 6);
 	platform_buffer_flush();
 
 	return 0;
@@ -129,17 +132,65 @@ void swdptap_bit_out(bool val)
 	platform_buffer_write(cmd, 3);
 }
 
+/* Clock in ticks bits on TDO, LSB first: whole bytes, then the remaining
+ * bits. Up to 33 bits take two commands and one reply. */
+static void swdptap_mpsse_in(uint8_t *data, int ticks)
+{
+	uint8_t cmd[5];
+	int index = 0;
+	int bytes = ticks >> 3;
+	int bits = ticks & 7;
+
+	if (bytes) {
+		cmd[index++] = MPSSE_DO_READ | MPSSE_LSB;
+		cmd[index++] = bytes - 1;
+		cmd[index++] = 0;
+	}
+	if (bits) {
+		cmd[index++] = MPSSE_DO_READ | MPSSE_LSB | MPSSE_BITMODE;
+		cmd[index++] = bits - 1;
+	}
+	platform_buffer_write(cmd, index);
+	platform_buffer_read(data, bytes + (bits ? 1 : 0));
+	/* Bits shift in from the top of the byte */
+	if (bits)
+		data[bytes] >>= 8 - bits;
+}
+
+static uint32_t swdptap_mpsse_seq_in(int ticks, bool *parity)
+{
+	uint8_t data[5];
+	uint32_t ret = 0;
+
+	swdptap_mpsse_in(data, parity ? ticks + 1 : ticks);
+	for (int i = 0; i < ticks; i++)
+		if (data[i >> 3] & (1 << (i & 7)))
+			ret |= (1u << i);
+	if (parity) {
+		unsigned int p = (data[ticks >> 3] >> (ticks & 7)) & 1;
+		for (uint32_t v = ret; v; v >>= 1)
+			p ^= v & 1;
+		*parity = p;
+	}
+	return ret;
+}
+
 bool swdptap_seq_in_parity(uint32_t *res, int ticks)
 {
 	int index = ticks + 1;
 	uint8_t cmd[4];
 	unsigned int parity = 0;
 
+	swdptap_turnaround(1);
+	if (active_cable->mpsse_swd_read) {
+		bool bad_parity;
+		*res = swdptap_mpsse_seq_in(ticks, &bad_parity);
+		return bad_parity;
+	}
 	cmd[0] = active_cable->bitbang_tms_in_port_cmd;
 	cmd[1] = MPSSE_TMS_SHIFT;
 	cmd[2] = 0;
 	cmd[3] = 0;
-	swdptap_turnaround(1);
 	while (index--) {
 		platform_buffer_write(cmd, 4);
 	}
@@ -163,12 +214,13 @@ uint32_t swdptap_seq_in(int ticks)
 	int index = ticks;
 	uint8_t cmd[4];
 
+	swdptap_turnaround(1);
+	if (active_cable->mpsse_swd_read)
+		return swdptap_mpsse_seq_in(ticks, NULL);
 	cmd[0] = active_cable->bitbang_tms_in_port_cmd;
 	cmd[1] = MPSSE_TMS_SHIFT;
 	cmd[2] = 0;
 	cmd[3] = 0;
-
-	swdptap_turnaround(1);
 	while (index--) {
 		platform_buffer_write(cmd, 4);
 	}
@@ -0,0 +1,415 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2020  Black Sphere Technologies Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* This file implements the ADIv5 DP access for the pc-hosted platform by
+ * running whole transactions on the probe via the remote protocol, instead
+ * of composing them from single SWD bit sequences. MEM-AP block transfers
+ * are run on the probe as well, including the TAR re-arm at 1 KiB
+ * boundaries, so a block costs one round trip instead of one per word.
+ */
+
+#include "general.h"
+#include "exception.h"
+#include "adiv5.h"
+#include "target.h"
+#include "target_internal.h"
+#include "remote.h"
+
+/* See remote.c/.h for protocol information */
+
+/* Start a binary framed high level packet, returns the payload offset */
+static int remote_adiv5_bin(uint8_t *construct, uint8_t cmd)
+{
+	construct[REMOTE_BIN_HDR] = REMOTE_HL_PACKET;
+	construct[REMOTE_BIN_HDR + 1] = cmd;
+	return REMOTE_BIN_HDR + 2;
+}
+
+static uint32_t remote_adiv5_result(ADIv5_DP_t *dp, const char *func,
+									uint8_t *construct, int s)
+{
+	if ((s < 1) || ((construct[0] != REMOTE_RESP_OK) &&
+					(construct[0] != REMOTE_RESP_ERR))) {
+		fprintf(stderr, "%s failed, error %s\n", func,
+				(s && !remote_binary) ? (char *)&(construct[1]) :
+				"short response");
+		exit(-1);
+	}
+	uint32_t res;
+	if (remote_binary)
+		res = (s >= 5) ? remote_get_u32(&construct[1]) : 0;
+	else
+		res = remotehston(-1, (char *)&construct[1]);
+	if (construct[0] == REMOTE_RESP_OK)
+		return res;
+	switch (res & 0xff) {
+	case REMOTE_ERROR_FAULT:
+		dp->fault = 1;
+		return 0;
+	case REMOTE_ERROR_EXCEPTION:
+		raise_exception(res >> 8, "Remote exception");
+		break;
+	default:
+		fprintf(stderr, "%s failed, error %" PRIx32 "\n", func, res);
+		exit(-1);
+	}
+	return 0;
+}
+
+static uint32_t remote_adiv5_dp_read(ADIv5_DP_t *dp, uint16_t addr)
+{
+	uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+	int s;
+
+	/* The probe talks to whichever DP was selected last */
+	adiv5_swdp_select(dp);
+	if ((addr & ADIV5_APnDP) && dp->fault)
+		return 0;
+	if (remote_binary) {
+		s = remote_adiv5_bin(construct, REMOTE_DP_READ);
+		remote_put_u16(&construct[s], addr);
+		s = platform_buffer_xfer_bin(construct, s + 2, PLATFORM_MAX_MSG_SIZE);
+		return remote_adiv5_result(dp, __func__, construct, s);
+	}
+	s = snprintf((char *)construct, PLATFORM_MAX_MSG_SIZE,
+				 REMOTE_DP_READ_STR, addr);
+	platform_buffer_write(construct, s);
+	s = platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+	return remote_adiv5_result(dp, __func__, construct, s);
+}
+
+static uint32_t remote_adiv5_dp_error(ADIv5_DP_t *dp)
+{
+	uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+	int s;
+
+	adiv5_swdp_select(dp);
+	if (remote_binary) {
+		s = remote_adiv5_bin(construct, REMOTE_DP_ERROR);
+		s = platform_buffer_xfer_bin(construct, s, PLATFORM_MAX_MSG_SIZE);
+	} else {
+		s = snprintf((char *)construct, PLATFORM_MAX_MSG_SIZE, "%s",
+					 REMOTE_DP_ERROR_STR);
+		platform_buffer_write(construct, s);
+		s = platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+	}
+	uint32_t err = remote_adiv5_result(dp, __func__, construct, s);
+	dp->fault = 0;
+	return err;
+}
+
+static uint32_t remote_adiv5_low_access(ADIv5_DP_t *dp, uint8_t RnW,
+										uint16_t addr, uint32_t value)
+{
+	uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+	int s;
+
+	/* The probe talks to whichever DP was selected last */
+	adiv5_swdp_select(dp);
+	if ((addr & ADIV5_APnDP) && dp->fault)
+		return 0;
+	if (remote_binary) {
+		s = remote_adiv5_bin(construct, REMOTE_LOW_ACCESS);
+		construct[s] = RnW;
+		remote_put_u16(&construct[s + 1], addr);
+		remote_put_u32(&construct[s + 3], value);
+		s = platform_buffer_xfer_bin(construct, s + 7, PLATFORM_MAX_MSG_SIZE);
+		return remote_adiv5_result(dp, __func__, construct, s);
+	}
+	s = snprintf((char *)construct, PLATFORM_MAX_MSG_SIZE,
+				 REMOTE_LOW_ACCESS_STR, RnW, addr, value);
+	platform_buffer_write(construct, s);
+	s = platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+	return remote_adiv5_result(dp, __func__, construct, s);
+}
+
+static void remote_adiv5_abort(ADIv5_DP_t *dp, uint32_t abort)
+{
+	remote_adiv5_low_access(dp, ADIV5_LOW_WRITE, ADIV5_DP_ABORT, abort);
+}
+
+/* CSW base value for H commands, with the packed transfer flag */
+static uint32_t remote_adiv5_csw(ADIv5_AP_t *ap)
+{
+	if (ap->packed && (remote_features & REMOTE_FEATURE_HL_PACKED))
+		return ap->csw | ADIV5_AP_CSW_ADDRINC_PACKED;
+	return ap->csw;
+}
+
+static void remote_adiv5_mem_read(ADIv5_AP_t *ap, void *dest, uint32_t src,
+								  size_t len)
+{
+	uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+	uint8_t *data = dest;
+	int s;
+
+	adiv5_swdp_select(ap->dp);
+	/* The probe moves SELECT, CSW and TAR on its own */
+	adiv5_dp_invalidate(ap->dp);
+	while (len && !ap->dp->fault) {
+		size_t count = MIN(len, REMOTE_MAX_MEM_BLOCK);
+		/* Raw data in binary responses, two hex digits per byte else */
+		size_t width = remote_binary ? 1 : 2;
+		if (remote_binary) {
+			s = remote_adiv5_bin(construct, REMOTE_AP_MEM_READ);
+			construct[s] = ap->apsel;
+			remote_put_u32(&construct[s + 1], remote_adiv5_csw(ap));
+			remote_put_u32(&construct[s + 5], src);
+			remote_put_u16(&construct[s + 9], count);
+			s = platform_buffer_xfer_bin(construct, s + 11,
+										 PLATFORM_MAX_MSG_SIZE);
+		} else {
+			s = snprintf((char *)construct, PLATFORM_MAX_MSG_SIZE,
+						 REMOTE_AP_MEM_READ_STR, ap->apsel, remote_adiv5_csw(ap),
+						 src, (unsigned int)count);
+			platform_buffer_write(construct, s);
+			s = platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+		}
+		if ((s > 0) && (construct[0] == REMOTE_RESP_OK) &&
+			(s != (int)(1 + width * count))) {
+			fprintf(stderr, "%s: short response\n", __func__);
+			exit(-1);
+		}
+		remote_adiv5_result(ap->dp, __func__, construct, s);
+		if (ap->dp->fault)
+			return;
+		if (remote_binary) {
+			memcpy(data, &construct[1], count);
+			data += count;
+		} else {
+			for (size_t i = 0; i < count; i++)
+				*data++ = remotehston(2, (char *)&construct[1 + 2 * i]);
+		}
+		src += count;
+		len -= count;
+	}
+}
+
+static void remote_adiv5_mem_write_sized(ADIv5_AP_t *ap, uint32_t dest,
+										 const void *src, size_t len,
+										 enum align align)
+{
+	uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+	const uint8_t *data = src;
+	int s;
+
+	adiv5_swdp_select(ap->dp);
+	adiv5_dp_invalidate(ap->dp);
+	while (len && !ap->dp->fault) {
+		size_t count = MIN(len, REMOTE_MAX_MEM_BLOCK);
+		if (remote_binary) {
+			s = remote_adiv5_bin(construct, REMOTE_AP_MEM_WRITE_SIZED);
+			construct[s] = ap->apsel;
+			remote_put_u32(&construct[s + 1], remote_adiv5_csw(ap));
+			construct[s + 5] = align;
+			remote_put_u32(&construct[s + 6], dest);
+			remote_put_u16(&construct[s + 10], count);
+			memcpy(&construct[s + 12], data, count);
+			data += count;
+			s = platform_buffer_xfer_bin(construct, s + 12 + count,
+										 PLATFORM_MAX_MSG_SIZE);
+		} else {
+			s = snprintf((char *)construct, PLATFORM_MAX_MSG_SIZE,
+						 REMOTE_AP_MEM_WRITE_SIZED_STR, ap->apsel,
+						 remote_adiv5_csw(ap), align, dest, (unsigned int)count);
+			for (size_t i = 0; i < count; i++)
+				s += snprintf((char *)&construct[s], PLATFORM_MAX_MSG_SIZE - s,
+							  "%02x", *data++);
+			construct[s++] = REMOTE_EOM;
+			construct[s] = 0;
+			platform_buffer_write(construct, s);
+			s = platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+		}
+		remote_adiv5_result(ap->dp, __func__, construct, s);
+		dest += count;
+		len -= count;
+	}
+}
+
+static void remote_adiv5_mem_batch(ADIv5_AP_t *ap, struct target_mem_op *ops,
+								   size_t count)
+{
+	uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+	int s;
+
+	adiv5_swdp_select(ap->dp);
+	adiv5_dp_invalidate(ap->dp);
+	while (count && !ap->dp->fault) {
+		size_t n = MIN(count, REMOTE_MAX_BATCH);
+		size_t width = remote_binary ? 1 : 2;
+		if (remote_binary) {
+			s = remote_adiv5_bin(construct, REMOTE_AP_MEM_BATCH);
+			construct[s] = ap->apsel;
+			remote_put_u32(&construct[s + 1], remote_adiv5_csw(ap));
+			construct[s + 5] = n;
+			s += 6;
+			for (size_t i = 0; i < n; i++) {
+				construct[s] = ops[i].size |
+					(ops[i].write ? REMOTE_BATCH_WRITE : 0);
+				remote_put_u32(&construct[s + 1], ops[i].addr);
+				remote_put_u32(&construct[s + 5], ops[i].value);
+				s += 9;
+			}
+			s = platform_buffer_xfer_bin(construct, s, PLATFORM_MAX_MSG_SIZE);
+		} else {
+			s = snprintf((char *)construct, PLATFORM_MAX_MSG_SIZE,
+						 REMOTE_AP_MEM_BATCH_STR, ap->apsel,
+						 remote_adiv5_csw(ap), (unsigned int)n);
+			for (size_t i = 0; i < n; i++)
+				s += snprintf((char *)&construct[s], PLATFORM_MAX_MSG_SIZE - s,
+							  "%02x%08" PRIx32 "%08" PRIx32,
+							  ops[i].size | (ops[i].write ? REMOTE_BATCH_WRITE : 0),
+							  ops[i].addr, ops[i].value);
+			construct[s++] = REMOTE_EOM;
+			construct[s] = 0;
+			platform_buffer_write(construct, s);
+			s = platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+		}
+		if ((s > 0) && (construct[0] == REMOTE_RESP_OK) &&
+			(s != (int)(1 + width * 4 * n))) {
+			fprintf(stderr, "%s: short response\n", __func__);
+			exit(-1);
+		}
+		remote_adiv5_result(ap->dp, __func__, construct, s);
+		if (ap->dp->fault)
+			return;
+		for (size_t i = 0; i < n; i++) {
+			if (remote_binary) {
+				ops[i].value = remote_get_u32(&construct[1 + 4 * i]);
+			} else {
+				uint8_t v[4];
+				for (size_t j = 0; j < 4; j++)
+					v[j] = remotehston(2, (char *)&construct[1 + 8 * i + 2 * j]);
+				ops[i].value = remote_get_u32(v);
+			}
+		}
+		ops += n;
+		count -= n;
+	}
+}
+
+/* The probe reads the whole range before answering, allow for slow
+ * targets and clocks. */
+#define REMOTE_CRC32_BYTES_PER_MS 16
+
+static uint32_t remote_adiv5_mem_crc32(ADIv5_AP_t *ap, uint32_t base,
+									   size_t len)
+{
+	uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+	int s;
+
+	adiv5_swdp_select(ap->dp);
+	if (ap->dp->fault)
+		return 0;
+	adiv5_dp_invalidate(ap->dp);
+	if (remote_binary) {
+		s = remote_adiv5_bin(construct, REMOTE_AP_MEM_CRC32);
+		construct[s] = ap->apsel;
+		remote_put_u32(&construct[s + 1], remote_adiv5_csw(ap));
+		remote_put_u32(&construct[s + 5], base);
+		remote_put_u32(&construct[s + 9], len);
+		platform_buffer_write_bin(construct, s + 13);
+	} else {
+		s = snprintf((char *)construct, PLATFORM_MAX_MSG_SIZE,
+					 REMOTE_AP_MEM_CRC32_STR, ap->apsel, remote_adiv5_csw(ap),
+					 base, (uint32_t)len);
+		platform_buffer_write(construct, s);
+	}
+	platform_buffer_wait(RESP_TIMEOUT + len / REMOTE_CRC32_BYTES_PER_MS);
+	s = platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+	return remote_adiv5_result(ap->dp, __func__, construct, s);
+}
+
+/* While the probe watches, come back every so often so the caller can
+ * look for a break request from GDB. */
+#define REMOTE_WATCH_WAIT_MS 50
+
+int remote_watch_interval = 1;
+static bool watch_running;
+
+static bool remote_adiv5_mem_watch(ADIv5_AP_t *ap, uint32_t addr,
+								   uint32_t mask)
+{
+	uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+	int s;
+
+	if (!watch_running) {
+		/* No acknowledge may be taken for the notification */
+		swdptap_flush();
+		adiv5_swdp_select(ap->dp);
+		adiv5_dp_invalidate(ap->dp);
+		if (remote_binary) {
+			s = remote_adiv5_bin(construct, REMOTE_AP_MEM_WATCH);
+			construct[s] = ap->apsel;
+			remote_put_u32(&construct[s + 1], remote_adiv5_csw(ap));
+			remote_put_u32(&construct[s + 5], addr);
+			remote_put_u32(&construct[s + 9], mask);
+			remote_put_u16(&construct[s + 13], remote_watch_interval);
+			platform_buffer_write_bin(construct, s + 15);
+		} else {
+			s = snprintf((char *)construct, PLATFORM_MAX_MSG_SIZE,
+						 REMOTE_AP_MEM_WATCH_STR, ap->apsel, remote_adiv5_csw(ap),
+						 addr, mask, remote_watch_interval);
+			platform_buffer_write(construct, s);
+		}
+		watch_running = true;
+	}
+	if (!platform_buffer_wait(REMOTE_WATCH_WAIT_MS))
+		return false;
+	watch_running = false;
+	s = platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+	remote_adiv5_result(ap->dp, __func__, construct, s);
+	return true;
+}
+
+void remote_adiv5_watch_cancel(void)
+{
+	uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+
+	if (!watch_running)
+		return;
+	watch_running = false;
+	construct[0] = REMOTE_WATCH_CANCEL;
+	construct[1] = 0;
+	platform_buffer_write(construct, 1);
+	/* The word is read again by the caller, only drain the response */
+	platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+}
+
+void platform_adiv5_dp_defaults(ADIv5_DP_t *dp)
+{
+	if (remote_features & REMOTE_FEATURE_HL_DP) {
+		dp->dp_read = remote_adiv5_dp_read;
+		dp->error = remote_adiv5_dp_error;
+		dp->low_access = remote_adiv5_low_access;
+		dp->abort = remote_adiv5_abort;
+		/* Bit level posted writes would only add round trips */
+		dp->write_posted = NULL;
+	}
+	if (remote_features & REMOTE_FEATURE_HL_MEM) {
+		dp->mem_read = remote_adiv5_mem_read;
+		dp->mem_write_sized = remote_adiv5_mem_write_sized;
+	}
+	if (remote_features & REMOTE_FEATURE_HL_CRC)
+		dp->mem_crc32 = remote_adiv5_mem_crc32;
+	if (remote_features & REMOTE_FEATURE_HL_BATCH)
+		dp->mem_batch = remote_adiv5_mem_batch;
+	if ((remote_features & REMOTE_FEATURE_HL_WATCH) && remote_watch_interval)
+		dp->mem_watch = remote_adiv5_mem_watch;
+}
@@ -88,31 +88,89 @@ void jtagtap_tms_seq(uint32_t MS, int ticks)
     }
 }
 
-void jtagtap_tdi_tdo_seq(uint8_t *DO, const uint8_t final_tms, const uint8_t *DI, int ticks)
+/* Scan of up to REMOTE_MAX_SCAN_BYTES with a single JX command */
+static void jtagtap_scan(uint8_t *DO, const uint8_t final_tms, const uint8_t *DI, int ticks)
 {
   uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+  int bytes = (ticks + 7) / 8;
   int s;
 
-  uint64_t DIl=*(uint64_t *)DI;
-
-  if(!ticks || !DI) return;
-
-  /* Reduce the length of DI according to the bits we're transmitting */
-  DIl&=(1L<<(ticks+1))-1;
-
-  s=snprintf((char *)construct,PLATFORM_MAX_MSG_SIZE,REMOTE_JTAG_TDIDO_STR,final_tms?REMOTE_TDITDO_TMS:REMOTE_TDITDO_NOTMS,ticks,DIl);
-  platform_buffer_write(construct,s);
+  if (remote_binary) {
+    construct[REMOTE_BIN_HDR] = REMOTE_JTAG_PACKET;
+    construct[REMOTE_BIN_HDR + 1] = REMOTE_SCAN;
+    construct[REMOTE_BIN_HDR + 2] = final_tms;
+    remote_put_u16(&construct[REMOTE_BIN_HDR + 3], ticks);
+    memcpy(&construct[REMOTE_BIN_HDR + 5], DI, bytes);
+    s=platform_buffer_xfer_bin(construct, REMOTE_BIN_HDR + 5 + bytes, PLATFORM_MAX_MSG_SIZE);
+  } else {
+    s=snprintf((char *)construct,PLATFORM_MAX_MSG_SIZE,REMOTE_JTAG_SCAN_STR,final_tms,ticks);
+    for (int i = 0; i < bytes; i++)
+      s+=snprintf((char *)&construct[s],PLATFORM_MAX_MSG_SIZE-s,"%02x",DI[i]);
+    construct[s++]=REMOTE_EOM;
+    construct[s]=0;
+    platform_buffer_write(construct,s);
+    s=platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+  }
 
-  s=platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
-  if ((!s) || (construct[0]==REMOTE_RESP_ERR))
+  if ((s != 1 + (remote_binary ? 1 : 2) * bytes) || (construct[0]!=REMOTE_RESP_OK))
     {
-      fprintf(stderr,"jtagtap_tms_seq failed, error %s\n",s?(char *)&(construct[1]):"unknown");
+      fprintf(stderr,"jtagtap_scan failed, error %s\n",
+              (s && !remote_binary)?(char *)&(construct[1]):"bad response");
       exit(-1);
     }
 
   if (DO) {
-      for (unsigned int i = 1; i*8 <= (unsigned int)ticks; i++)
-          DO[i - 1] = remotehston(2 , (char *)&construct[s - (i * 2)]);
+    for (int i = 0; i < bytes; i++)
+      DO[i] = remote_binary ? construct[1 + i] : remotehston(2 , (char *)&construct[1 + 2 * i]);
+  }
+}
+
+void jtagtap_tdi_tdo_seq(uint8_t *DO, const uint8_t final_tms, const uint8_t *DI, int ticks)
+{
+  uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+  int s;
+
+  if(!ticks || !DI) return;
+
+  /* Long scans are split, only the last chunk may leave the shift state.
+   * Probes without JX take at most 64 bits per command. */
+  int max_chunk = (remote_features & REMOTE_FEATURE_JTAG_SCAN) ? REMOTE_MAX_SCAN_BYTES * 8 : 64;
+  while (ticks) {
+    int chunk = MIN(ticks, max_chunk);
+    int bytes = (chunk + 7) / 8;
+    uint8_t tms = final_tms && (chunk == ticks);
+
+    if (remote_features & REMOTE_FEATURE_JTAG_SCAN) {
+      jtagtap_scan(DO, tms, DI, chunk);
+    } else {
+      uint64_t DIl = 0;
+      for (int i = 0; i < bytes; i++)
+        DIl |= (uint64_t)DI[i] << (8 * i);
+
+      /* Reduce the length of DI according to the bits we're transmitting */
+      if (chunk < 64)
+        DIl&=(1ULL<<chunk)-1;
+
+      s=snprintf((char *)construct,PLATFORM_MAX_MSG_SIZE,REMOTE_JTAG_TDIDO_STR,tms?REMOTE_TDITDO_TMS:REMOTE_TDITDO_NOTMS,chunk,(unsigned long)DIl);
+      platform_buffer_write(construct,s);
+
+      s=platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+      if ((!s) || (construct[0]==REMOTE_RESP_ERR))
+        {
+          fprintf(stderr,"jtagtap_tdi_tdo_seq failed, error %s\n",s?(char *)&(construct[1]):"unknown");
+          exit(-1);
+        }
+
+      if (DO) {
+        uint64_t DOl = remotehston(-1, (char *)&construct[1]);
+        for (int i = 0; i < bytes; i++)
+          DO[i] = DOl >> (8 * i);
+      }
+    }
+    if (DO)
+      DO += bytes;
+    DI += bytes;
+    ticks -= chunk;
   }
 }
 
@@ -142,3 +200,59 @@ uint8_t jtagtap_next(uint8_t dTMS, uint8_t dTDI)
 
   return remotehston(-1,(char *)&construct[1]);
 }
+
+/* Run jtag_dev_shift_dr_seq() on the probe, JQ commands moving as many
+ * scans as fit into REMOTE_MAX_SCAN_BYTES. Returns false if the probe
+ * can not. */
+bool platform_jtag_dr_seq(uint8_t *DO, const uint8_t *DI, int ticks, int count,
+                          int prescan, int postscan)
+{
+  uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+  int bytes = (ticks + 7) / 8;
+  int s;
+
+  if (!(remote_features & REMOTE_FEATURE_JTAG_DR_SEQ) || (ticks > 0xff) ||
+      (bytes > REMOTE_MAX_SCAN_BYTES) || (prescan > 0xff) || (postscan > 0xff))
+    return false;
+
+  while (count) {
+    int n = MIN(count, REMOTE_MAX_SCAN_BYTES / bytes);
+    int len = n * bytes;
+
+    if (remote_binary) {
+      construct[REMOTE_BIN_HDR] = REMOTE_JTAG_PACKET;
+      construct[REMOTE_BIN_HDR + 1] = REMOTE_DR_SEQ;
+      construct[REMOTE_BIN_HDR + 2] = prescan;
+      construct[REMOTE_BIN_HDR + 3] = postscan;
+      construct[REMOTE_BIN_HDR + 4] = ticks;
+      remote_put_u16(&construct[REMOTE_BIN_HDR + 5], n);
+      memcpy(&construct[REMOTE_BIN_HDR + 7], DI, len);
+      s=platform_buffer_xfer_bin(construct, REMOTE_BIN_HDR + 7 + len, PLATFORM_MAX_MSG_SIZE);
+    } else {
+      s=snprintf((char *)construct,PLATFORM_MAX_MSG_SIZE,REMOTE_JTAG_DR_SEQ_STR,
+                 prescan,postscan,ticks,n);
+      for (int i = 0; i < len; i++)
+        s+=snprintf((char *)&construct[s],PLATFORM_MAX_MSG_SIZE-s,"%02x",DI[i]);
+      construct[s++]=REMOTE_EOM;
+      construct[s]=0;
+      platform_buffer_write(construct,s);
+      s=platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+    }
+
+    if ((s != 1 + (remote_binary ? 1 : 2) * len) || (construct[0]!=REMOTE_RESP_OK))
+      {
+        fprintf(stderr,"jtag_dr_seq failed, error %s\n",
+                (s && !remote_binary)?(char *)&(construct[1]):"bad response");
+        exit(-1);
+      }
+
+    if (DO) {
+      for (int i = 0; i < len; i++)
+        DO[i] = remote_binary ? construct[1 + i] : remotehston(2 , (char *)&construct[1 + 2 * i]);
+      DO += len;
+    }
+    DI += len;
+    count -= n;
+  }
+  return true;
+}
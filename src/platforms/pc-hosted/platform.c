@@ -32,6 +32,8 @@
 
 #include "cl_utils.h"
 static BMP_CL_OPTIONS_t cl_opts; /* Portable way to nullify the struct*/
+uint32_t remote_version, remote_features;
+bool remote_binary;
 
 void platform_init(int argc, char **argv)
 {
@@ -44,8 +46,10 @@ void platform_init(int argc, char **argv)
   printf("License GPLv3+: GNU GPL version 3 or later "
 	 "<http://gnu.org/licenses/gpl.html>\n\n");
 
-  if (serial_open(&cl_opts))
+  if (session_open(&cl_opts))
 	  exit(-1);
+  if (cl_opts.opt_cache_file)
+	  probe_cache_open(cl_opts.opt_cache_file);
   int c=snprintf(construct,PLATFORM_MAX_MSG_SIZE,"%s",REMOTE_START_STR);
   platform_buffer_write((uint8_t *)construct,c);
   c=platform_buffer_read((uint8_t *)construct, PLATFORM_MAX_MSG_SIZE);
@@ -57,11 +61,29 @@ void platform_init(int argc, char **argv)
     }
 
   printf("Remote is %s\n",&construct[1]);
+
+  /* Use the fastest paths the probe firmware offers. Older firmware
+   * does not know GF and is left at plain SWD/JTAG bit sequences. */
+  c=snprintf(construct,PLATFORM_MAX_MSG_SIZE,"%s",REMOTE_FEATURES_STR);
+  platform_buffer_write((uint8_t *)construct,c);
+  c=platform_buffer_read((uint8_t *)construct, PLATFORM_MAX_MSG_SIZE);
+  if ((c > 0) && (construct[0] == REMOTE_RESP_OK))
+    {
+      uint64_t features = remotehston(-1, &construct[1]);
+      remote_version = features >> 32;
+      remote_features = features & 0xffffffff;
+    }
+  remote_binary = remote_features & REMOTE_FEATURE_BINARY;
+  remote_watch_interval = cl_opts.opt_halt_poll_ms;
+  if (cl_opts.opt_max_frequency)
+	  platform_max_frequency_set(cl_opts.opt_max_frequency);
+  DEBUG("Remote protocol version %" PRIu32 ", features 0x%08" PRIx32 "\n",
+        remote_version, remote_features);
   if (cl_opts.opt_mode != BMP_MODE_DEBUG) {
 	  int ret = cl_execute(&cl_opts);
 	  if (cl_opts.opt_tpwr)
 		  platform_target_set_power(0);
-	  serial_close();
+	  session_close();
 	  exit(ret);
   } else {
 	  assert(gdb_if_init() == 0);
@@ -141,11 +163,67 @@ bool platform_srst_get_val(void)
   return (construct[1]=='1');
 }
 
+void platform_max_frequency_set(uint32_t frequency)
+{
+  uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+  int s;
+
+  if (!(remote_features & REMOTE_FEATURE_FREQ))
+    {
+      DEBUG("Probe firmware can not set the SWCLK/TCK frequency\n");
+      return;
+    }
+  s=snprintf((char *)construct,PLATFORM_MAX_MSG_SIZE,REMOTE_FREQ_SET_STR,frequency);
+  platform_buffer_write(construct,s);
+
+  s=platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+
+  if ((!s) || (construct[0]==REMOTE_RESP_ERR))
+    {
+      fprintf(stderr,"platform_max_frequency_set failed, error %s\n",s?(char *)&(construct[1]):"unknown");
+      exit(-1);
+    }
+}
+
+uint32_t platform_max_frequency_get(void)
+{
+  uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+  int s;
+
+  if (!(remote_features & REMOTE_FEATURE_FREQ))
+    return 0;
+  s=snprintf((char *)construct,PLATFORM_MAX_MSG_SIZE,"%s",REMOTE_FREQ_GET_STR);
+  platform_buffer_write(construct,s);
+
+  s=platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+
+  if ((!s) || (construct[0]==REMOTE_RESP_ERR))
+    {
+      fprintf(stderr,"platform_max_frequency_get failed, error %s\n",s?(char *)&(construct[1]):"unknown");
+      exit(-1);
+    }
+
+  return remotehston(-1, (char *)&construct[1]);
+}
+
 void platform_buffer_flush(void)
 {
 
 }
 
+void platform_buffer_write_bin(uint8_t *construct, int size)
+{
+  construct[0] = REMOTE_BIN_SOM;
+  remote_put_u16(&construct[1], size - REMOTE_BIN_HDR);
+  platform_buffer_write(construct, size);
+}
+
+int platform_buffer_xfer_bin(uint8_t *construct, int size, int maxsize)
+{
+  platform_buffer_write_bin(construct, size);
+  return platform_buffer_read(construct, maxsize);
+}
+
 const char *platform_target_voltage(void)
 
 {
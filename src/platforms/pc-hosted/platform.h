@@ -34,7 +34,11 @@
 
 #define PLATFORM_HAS_DEBUG
 #define PLATFORM_HAS_POWER_SWITCH
-#define PLATFORM_MAX_MSG_SIZE (256)
+#define PLATFORM_HAS_REMOTE_ADIV5
+#define PLATFORM_HAS_PROBE_CACHE
+#define PLATFORM_HAS_JTAG_DR_SEQ
+#define PLATFORM_HAS_SWDPTAP_TRANSFER
+#define PLATFORM_MAX_MSG_SIZE (1024)
 #define PLATFORM_IDENT "PC-HOSTED"
 #define BOARD_IDENT PLATFORM_IDENT
 #define SET_RUN_STATE(state)
@@ -47,6 +51,33 @@
 void platform_buffer_flush(void);
 int platform_buffer_write(const uint8_t *data, int size);
 int platform_buffer_read(uint8_t *data, int size);
+/* Send the binary framed packet in construct, class and command at
+ * construct[REMOTE_BIN_HDR], and read the response back into it */
+void platform_buffer_write_bin(uint8_t *construct, int size);
+int platform_buffer_xfer_bin(uint8_t *construct, int size, int maxsize);
+/* Protocol version and REMOTE_FEATURE_* reported by the probe */
+extern uint32_t remote_version, remote_features;
+extern bool remote_binary;
+/* Collect the acknowledges of queued SWD write sequences */
+void swdptap_flush(void);
+bool platform_swdptap_transfer(uint8_t request, uint32_t *data, uint8_t *ack,
+                               bool *badParity);
+/* Wait up to timeout_ms for response data */
+bool platform_buffer_wait(int timeout_ms);
+/* See jtag_dev_shift_dr_seq() */
+bool platform_jtag_dr_seq(uint8_t *DO, const uint8_t *DI, int ticks, int count,
+                          int prescan, int postscan);
+/* Probe side halt poll interval in ms, 0 to poll from the host */
+extern int remote_watch_interval;
+void remote_adiv5_watch_cancel(void);
+
+struct ADIv5_DP_s;
+void platform_adiv5_dp_defaults(struct ADIv5_DP_s *dp);
+/* Probe results kept across sessions, see probe_cache.c */
+void probe_cache_open(const char *file);
+const char *platform_probe_cache_get(const char *key);
+void platform_probe_cache_put(const char *key, const char *value);
+
 static inline int platform_hwversion(void)
 {
   return 0;
@@ -0,0 +1,183 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2020  Black Sphere Technologies Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* This file keeps the probe cache (-k) of the pc-hosted platform: the
+ * results of the ROM table walk and target driver probes, so a re-attach
+ * to the same target skips them. adiv5.c decides what goes in, this file
+ * only stores key/value lines:
+ *	<key>\t<value>
+ * The file is rewritten whenever an entry changes. Sessions sharing it
+ * take a lock on <file>.lock, merge in what the others wrote and replace
+ * the file by rename from a unique temporary file. Windows has no flock,
+ * sessions there should not share a file. */
+
+#include "general.h"
+#include "cl_utils.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+# include <sys/file.h>
+# include <sys/stat.h>
+#endif
+
+#define PROBE_CACHE_HEADER "# BMP probe cache\n"
+#define PROBE_CACHE_ENTRIES 64
+
+static const char *cache_file;
+static struct {
+	char *key;
+	char *value;
+	bool changed; /* Put since the last write, wins over the file */
+} cache[PROBE_CACHE_ENTRIES];
+static int cache_entries;
+
+static int probe_cache_find(const char *key)
+{
+	for (int i = 0; i < cache_entries; i++)
+		if (!strcmp(cache[i].key, key))
+			return i;
+	return -1;
+}
+
+/* Take in the entries of f, keeping the ones changed by this session */
+static void probe_cache_read(FILE *f)
+{
+	char line[256];
+
+	while (fgets(line, sizeof(line), f)) {
+		char *tab = strchr(line, '\t');
+		if ((line[0] == '#') || !tab)
+			continue;
+		*tab = 0;
+		tab[strcspn(tab + 1, "\n") + 1] = 0;
+		int i = probe_cache_find(line);
+		if (i < 0) {
+			if (cache_entries == PROBE_CACHE_ENTRIES)
+				continue;
+			i = cache_entries++;
+			cache[i].key = strdup(line);
+			cache[i].value = NULL;
+			cache[i].changed = false;
+		} else if (cache[i].changed) {
+			continue;
+		}
+		free(cache[i].value);
+		cache[i].value = strdup(tab + 1);
+	}
+}
+
+void probe_cache_open(const char *file)
+{
+	cache_file = file;
+	FILE *f = fopen(file, "r");
+	if (!f)
+		return;
+	probe_cache_read(f);
+	fclose(f);
+	DEBUG("Probe cache %s: %d entries\n", file, cache_entries);
+}
+
+const char *platform_probe_cache_get(const char *key)
+{
+	int i = probe_cache_find(key);
+	return (i < 0) ? NULL : cache[i].value;
+}
+
+static void probe_cache_write(void)
+{
+	char tmp[strlen(cache_file) + 8];
+	FILE *f;
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+	snprintf(tmp, sizeof(tmp), "%s.tmp", cache_file);
+	f = fopen(tmp, "w");
+#else
+	char lock[strlen(cache_file) + 8];
+	snprintf(lock, sizeof(lock), "%s.lock", cache_file);
+	int lock_fd = open(lock, O_RDWR | O_CREAT, 0666);
+	if ((lock_fd < 0) || flock(lock_fd, LOCK_EX))
+		DEBUG("Can not lock probe cache %s: %s\n", lock, strerror(errno));
+	/* Other sessions may have added entries since we read the file */
+	FILE *old = fopen(cache_file, "r");
+	if (old) {
+		probe_cache_read(old);
+		fclose(old);
+	}
+	snprintf(tmp, sizeof(tmp), "%s.XXXXXX", cache_file);
+	int fd = mkstemp(tmp);
+	f = NULL;
+	if (fd >= 0) {
+		fchmod(fd, 0644);
+		f = fdopen(fd, "w");
+		if (!f)
+			close(fd);
+	}
+#endif
+	if (!f) {
+		DEBUG("Can not write probe cache %s: %s\n", tmp, strerror(errno));
+	} else {
+		fprintf(f, PROBE_CACHE_HEADER);
+		for (int i = 0; i < cache_entries; i++)
+			fprintf(f, "%s\t%s\n", cache[i].key, cache[i].value);
+		fclose(f);
+#if defined(_WIN32) || defined(__CYGWIN__)
+		/* rename() does not replace an existing file on Windows */
+		remove(cache_file);
+#endif
+		if (rename(tmp, cache_file)) {
+			DEBUG("Can not replace probe cache %s: %s\n", cache_file,
+				  strerror(errno));
+			remove(tmp);
+		} else {
+			for (int i = 0; i < cache_entries; i++)
+				cache[i].changed = false;
+		}
+	}
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+	if (lock_fd >= 0)
+		close(lock_fd);
+#endif
+}
+
+void platform_probe_cache_put(const char *key, const char *value)
+{
+	if (!cache_file)
+		return;
+	int i = probe_cache_find(key);
+	if (i >= 0) {
+		if (!strcmp(cache[i].value, value))
+			return;
+		free(cache[i].value);
+	} else if (cache_entries < PROBE_CACHE_ENTRIES) {
+		i = cache_entries++;
+		cache[i].key = strdup(key);
+	} else {
+		/* Full, replace the oldest entry */
+		free(cache[0].key);
+		free(cache[0].value);
+		memmove(&cache[0], &cache[1], (PROBE_CACHE_ENTRIES - 1) * sizeof(cache[0]));
+		i = PROBE_CACHE_ENTRIES - 1;
+		cache[i].key = strdup(key);
+	}
+	cache[i].value = strdup(value);
+	cache[i].changed = true;
+	probe_cache_write();
+}
@@ -0,0 +1,208 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2020  Black Sphere Technologies Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* This file routes the remote protocol traffic of the pc-hosted platform
+ * to the serial backend. The traffic can be recorded to a session file
+ * (-L) and a recorded session can be replayed without a probe (-l), so
+ * the host side of attach, dump and flash sequences can be timed and
+ * profiled repeatably.
+ *
+ * The session file starts with the SESSION_HEADER line, followed by one
+ * line per request and response:
+ *	W <usec> <hex data>
+ *	R <usec> <hex data>
+ * with <usec> counted from the start of the session.
+ * Replay serves the responses as fast as they are asked for and exits
+ * when the host sends a request that differs from the recording.
+ */
+
+#include "general.h"
+#include "remote.h"
+#include "cl_utils.h"
+
+#include <sys/time.h>
+#include <ctype.h>
+#include <errno.h>
+
+#define SESSION_HEADER "# BMP remote session\n"
+/* Hex encoded, with the record type and timestamp in front */
+#define SESSION_LINE_SIZE (4 * PLATFORM_MAX_MSG_SIZE + 32)
+
+static FILE *record_file;
+static FILE *replay_file;
+static uint64_t session_start;
+/* Last record read from the replay file, consumed when type is reset */
+static char replay_type;
+static uint64_t replay_usec, replay_last_usec;
+static uint8_t replay_data[2 * PLATFORM_MAX_MSG_SIZE];
+static int replay_size;
+static unsigned long replay_line, replay_count;
+
+static uint64_t session_usec(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec - session_start;
+}
+
+static void session_record(char type, const uint8_t *data, int size)
+{
+	fprintf(record_file, "%c %" PRIu64 " ", type, session_usec());
+	for (int i = 0; i < size; i++)
+		fprintf(record_file, "%02x", data[i]);
+	fprintf(record_file, "\n");
+}
+
+/* Read the next record into replay_*, returns false at end of file */
+static bool session_next(void)
+{
+	static char line[SESSION_LINE_SIZE];
+	char *p;
+
+	if (replay_type)
+		return true;
+	do {
+		if (!fgets(line, sizeof(line), replay_file))
+			return false;
+		replay_line++;
+	} while (line[0] == '#');
+	replay_type = line[0];
+	replay_usec = strtoull(&line[2], &p, 10);
+	replay_size = 0;
+	if ((replay_type != 'W') && (replay_type != 'R'))
+		goto bad;
+	while (*p == ' ')
+		p++;
+	while (isxdigit((unsigned char)p[0]) && isxdigit((unsigned char)p[1])) {
+		if (replay_size == sizeof(replay_data))
+			goto bad;
+		char hex[3] = {p[0], p[1], 0};
+		replay_data[replay_size++] = strtoul(hex, NULL, 16);
+		p += 2;
+	}
+	if ((*p != '\n') && *p)
+		goto bad;
+	replay_last_usec = replay_usec;
+	return true;
+  bad:
+	fprintf(stderr, "Replay: malformed record at line %lu\n", replay_line);
+	exit(-3);
+}
+
+int session_open(BMP_CL_OPTIONS_t *opt)
+{
+	if (opt->opt_replay_file) {
+		replay_file = fopen(opt->opt_replay_file, "r");
+		if (!replay_file) {
+			fprintf(stderr, "Can not open session %s: %s\n",
+					opt->opt_replay_file, strerror(errno));
+			return -1;
+		}
+		printf("Replaying session %s\n", opt->opt_replay_file);
+	} else if (serial_open(opt)) {
+		return -1;
+	}
+	if (opt->opt_record_file) {
+		record_file = fopen(opt->opt_record_file, "w");
+		if (!record_file) {
+			fprintf(stderr, "Can not create session %s: %s\n",
+					opt->opt_record_file, strerror(errno));
+			return -1;
+		}
+		/* Keep what was recorded when the session is interrupted */
+		setvbuf(record_file, NULL, _IOLBF, 0);
+		fprintf(record_file, SESSION_HEADER);
+	}
+	session_start = 0;
+	session_start = session_usec();
+	return 0;
+}
+
+void session_close(void)
+{
+	if (record_file) {
+		fclose(record_file);
+		record_file = NULL;
+	}
+	if (!replay_file) {
+		serial_close();
+		return;
+	}
+	uint64_t elapsed = session_usec();
+	printf("Replayed %lu records, recorded %" PRIu64 " us, "
+		   "replay %" PRIu64 " us\n", replay_count, replay_last_usec, elapsed);
+	fclose(replay_file);
+	replay_file = NULL;
+}
+
+int platform_buffer_write(const uint8_t *data, int size)
+{
+	int s = size;
+
+	/* The probe only listens again once a running watch has ended */
+	remote_adiv5_watch_cancel();
+	if (replay_file) {
+		if (!session_next() || (replay_type != 'W') ||
+			(replay_size != size) || memcmp(replay_data, data, size)) {
+			fprintf(stderr, "Replay diverged at line %lu\n", replay_line);
+			exit(-3);
+		}
+		replay_type = 0;
+		replay_count++;
+	} else {
+		s = serial_buffer_write(data, size);
+	}
+	if (record_file)
+		session_record('W', data, size);
+	return s;
+}
+
+bool platform_buffer_wait(int timeout_ms)
+{
+	if (replay_file)
+		return session_next() && (replay_type == 'R');
+	return serial_buffer_wait(timeout_ms);
+}
+
+int platform_buffer_read(uint8_t *data, int maxsize)
+{
+	int s;
+
+	/* Responses come in order, queued write acknowledges first */
+	swdptap_flush();
+	if (replay_file) {
+		if (!session_next() || (replay_type != 'R') || (replay_size > maxsize)) {
+			fprintf(stderr, "Replay diverged at line %lu\n", replay_line);
+			exit(-3);
+		}
+		replay_type = 0;
+		replay_count++;
+		s = replay_size;
+		memcpy(data, replay_data, s);
+		/* ASCII responses come back NUL terminated */
+		if (s < maxsize)
+			data[s] = 0;
+	} else {
+		s = serial_buffer_read(data, maxsize);
+	}
+	if (record_file)
+		session_record('R', data, s);
+	return s;
+}
@@ -50,12 +50,105 @@ int swdptap_init(void)
 }
 
 
+/* Write-only sequences are sent without waiting for their acknowledge,
+ * which carries no information. The acknowledges are collected when the
+ * next response is read, or when the queue is full, and any error is
+ * reported against the queued sequence that caused it.
+ */
+#define SWDPTAP_MAX_PENDING 64
+
+static struct {
+  const char *func;
+  uint32_t MS;
+  int ticks;
+} pending[SWDPTAP_MAX_PENDING];
+static int pending_count;
+
+void swdptap_flush(void)
+{
+  uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+  int count = pending_count;
+  int s;
+
+  /* platform_buffer_read() comes back here, so empty the queue first */
+  pending_count = 0;
+  for (int i = 0; i < count; i++)
+    {
+      s=platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+      if ((s<1) || (construct[0]==REMOTE_RESP_ERR))
+        {
+          fprintf(stderr,"%s(0x%08" PRIx32 ", %d) failed, error ",
+                  pending[i].func, pending[i].MS, pending[i].ticks);
+          if (s<1)
+            fprintf(stderr,"short response\n");
+          else if (remote_binary)
+            fprintf(stderr,"%" PRIx32 "\n",
+                    (s<5) ? 0 : remote_get_u32(&construct[1]));
+          else
+            fprintf(stderr,"%s\n",(char *)&(construct[1]));
+          exit(-1);
+        }
+    }
+}
+
+static void swdptap_queue(const char *func, uint32_t MS, int ticks)
+{
+  if (pending_count == SWDPTAP_MAX_PENDING)
+    swdptap_flush();
+  pending[pending_count].func = func;
+  pending[pending_count].MS = MS;
+  pending[pending_count].ticks = ticks;
+  pending_count++;
+}
+
+/* Binary framed variant of the sequence commands, see remote.h */
+static void swdptap_seq_bin_send(uint8_t *construct, uint8_t cmd, uint32_t MS,
+                                 int ticks)
+{
+  uint8_t *p = &construct[REMOTE_BIN_HDR];
+
+  *p++ = REMOTE_SWDP_PACKET;
+  *p++ = cmd;
+  *p++ = ticks;
+  if ((cmd == REMOTE_OUT) || (cmd == REMOTE_OUT_PAR)) {
+    remote_put_u32(p, MS);
+    p += 4;
+  }
+  platform_buffer_write_bin(construct, p - construct);
+}
+
+static uint32_t swdptap_seq_bin(const char *func, uint8_t cmd, uint32_t MS,
+                                int ticks, bool *badParity)
+{
+  uint8_t construct[REMOTE_BIN_HDR + 16];
+  int s;
+
+  swdptap_seq_bin_send(construct, cmd, MS, ticks);
+  s = platform_buffer_read(construct, sizeof(construct));
+  if ((s < 5) || (construct[0] == REMOTE_RESP_ERR))
+    {
+      fprintf(stderr,"%s failed, error %" PRIx32 "\n", func,
+              (s < 5) ? 0 : remote_get_u32(&construct[1]));
+      exit(-1);
+    }
+
+  if (badParity)
+    *badParity = (construct[0] != REMOTE_RESP_OK);
+  return remote_get_u32(&construct[1]);
+}
+
 bool swdptap_seq_in_parity(uint32_t *res, int ticks)
 
 {
   uint8_t construct[PLATFORM_MAX_MSG_SIZE];
   int s;
 
+  if (remote_binary) {
+    bool badParity;
+    *res = swdptap_seq_bin(__func__, REMOTE_IN_PAR, 0, ticks, &badParity);
+    return badParity;
+  }
+
   s=sprintf((char *)construct,REMOTE_SWDP_IN_PAR_STR,ticks);
   platform_buffer_write(construct,s);
 
@@ -76,6 +169,9 @@ uint32_t swdptap_seq_in(int ticks)
   uint8_t construct[PLATFORM_MAX_MSG_SIZE];
   int s;
 
+  if (remote_binary)
+    return swdptap_seq_bin(__func__, REMOTE_IN, 0, ticks, NULL);
+
   s=sprintf((char *)construct,REMOTE_SWDP_IN_STR,ticks);
   platform_buffer_write(construct,s);
 
@@ -94,15 +190,13 @@ void swdptap_seq_out(uint32_t MS, int ticks)
   uint8_t construct[PLATFORM_MAX_MSG_SIZE];
   int s;
 
-  s=sprintf((char *)construct,REMOTE_SWDP_OUT_STR,ticks,MS);
-  platform_buffer_write(construct,s);
-
-  s=platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
-  if ((s<1) || (construct[0]==REMOTE_RESP_ERR))
-    {
-      fprintf(stderr,"swdptap_seq_out failed, error %s\n",s?(char *)&(construct[1]):"short response");
-      exit(-1);
-    }
+  if (remote_binary) {
+    swdptap_seq_bin_send(construct, REMOTE_OUT, MS, ticks);
+  } else {
+    s=sprintf((char *)construct,REMOTE_SWDP_OUT_STR,ticks,MS);
+    platform_buffer_write(construct,s);
+  }
+  swdptap_queue(__func__, MS, ticks);
 }
 
 
@@ -111,13 +205,54 @@ void swdptap_seq_out_parity(uint32_t MS, int ticks)
   uint8_t construct[PLATFORM_MAX_MSG_SIZE];
   int s;
 
-  s=sprintf((char *)construct,REMOTE_SWDP_OUT_PAR_STR,ticks,MS);
-  platform_buffer_write(construct,s);
+  if (remote_binary) {
+    swdptap_seq_bin_send(construct, REMOTE_OUT_PAR, MS, ticks);
+  } else {
+    s=sprintf((char *)construct,REMOTE_SWDP_OUT_PAR_STR,ticks,MS);
+    platform_buffer_write(construct,s);
+  }
+  swdptap_queue(__func__, MS, ticks);
+}
 
-  s=platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
-  if ((s<1) || (construct[1]==REMOTE_RESP_ERR))
+/* One SWD transfer in one round trip, see swdptap_transfer() */
+bool platform_swdptap_transfer(uint8_t request, uint32_t *data, uint8_t *ack,
+                               bool *badParity)
+{
+  uint8_t construct[PLATFORM_MAX_MSG_SIZE];
+  uint64_t resp = 0;
+  int s;
+
+  if (!(remote_features & REMOTE_FEATURE_SWDP_TRANSFER))
+    return false;
+
+  if (remote_binary) {
+    construct[REMOTE_BIN_HDR] = REMOTE_SWDP_PACKET;
+    construct[REMOTE_BIN_HDR + 1] = REMOTE_TRANSFER;
+    construct[REMOTE_BIN_HDR + 2] = request;
+    remote_put_u32(&construct[REMOTE_BIN_HDR + 3], *data);
+    s=platform_buffer_xfer_bin(construct, REMOTE_BIN_HDR + 7, PLATFORM_MAX_MSG_SIZE);
+    if (s == 6)
+      resp = ((uint64_t)construct[1] << 32) | remote_get_u32(&construct[2]);
+  } else {
+    s=snprintf((char *)construct,PLATFORM_MAX_MSG_SIZE,REMOTE_SWDP_TRANSFER_STR,
+               request,*data);
+    platform_buffer_write(construct,s);
+    s=platform_buffer_read(construct, PLATFORM_MAX_MSG_SIZE);
+    if (s >= 2)
+      resp = remotehston(-1,(char *)&construct[1]);
+  }
+
+  if ((s < 2) || (remote_binary && (s != 6)) || (construct[0]==REMOTE_RESP_ERR))
     {
-      fprintf(stderr,"swdptap_seq_out_parity failed, error %s\n",s?(char *)&(construct[2]):"short response");
+      fprintf(stderr,"swdptap_transfer failed, error %s\n",
+              (s && !remote_binary)?(char *)&(construct[1]):"bad response");
       exit(-1);
     }
+
+  *ack = resp >> 32;
+  if ((*ack == SWDP_ACK_OK) && (request & 0x04)) {
+    *data = resp;
+    *badParity = (construct[0]!=REMOTE_RESP_OK);
+  }
+  return true;
 }
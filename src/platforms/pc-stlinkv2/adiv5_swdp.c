@@ -29,8 +29,9 @@
 #include "adiv5.h"
 #include "stlinkv2.h"
 
-int adiv5_swdp_scan(void)
+int adiv5_swdp_scan(uint32_t targetid)
 {
+	(void)targetid; /* No multi-drop support in the ST-Link firmware */
 	target_list_free();
 	ADIv5_DP_t *dp = (void*)calloc(1, sizeof(*dp));
 	if (stlink_enter_debug_swd())
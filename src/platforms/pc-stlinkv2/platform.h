@@ -34,6 +34,8 @@
 #endif
 
 #define PLATFORM_HAS_DEBUG
+/* The ST-Link scans by itself, the clock can not be tuned by scans */
+#define PLATFORM_NO_FREQUENCY_AUTO
 
 #define PLATFORM_IDENT "StlinkV2/3"
 #define SET_RUN_STATE(state)
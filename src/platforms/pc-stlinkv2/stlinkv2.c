@@ -223,13 +223,29 @@ typedef struct {
 	uint16_t     block_size;
 	bool         ap_error;
 	libusb_device_handle *handle;
-	struct libusb_transfer* req_trans;
-	struct libusb_transfer* rep_trans;
 } stlink;
 
 stlink Stlink;
 
+/* SWCLK/TCK frequency asked for, 0 for the defaults, and the one set */
+static uint32_t max_frequency;
+static uint32_t stlink_frequency;
+
+/* Clocks of the V2 probes, fastest first */
+struct stlink_freq {
+	uint16_t khz;
+	uint16_t divisor;
+};
+static const struct stlink_freq stlink_swd_freq[] = {
+	{4000, 0}, {1800, 1}, {1200, 2}, {950, 3}, {480, 7}, {240, 15},
+	{125, 31}, {100, 40}, {50, 79}, {25, 158}, {15, 265}, {5, 798},
+};
+static const struct stlink_freq stlink_jtag_freq[] = {
+	{18000, 2}, {9000, 4}, {4500, 8}, {2250, 16}, {1125, 32}, {562, 64},
+};
+
 static int stlink_usb_get_rw_status(bool verbose);
+static int stlink_usb_error_check(uint8_t *data, bool verbose);
 
 static void exit_function(void)
 {
@@ -314,104 +330,224 @@ static void LIBUSB_CALL on_trans_done(struct libusb_transfer * trans)
     ctx->flags |= TRANS_FLAGS_IS_DONE;
 }
 
-static int submit_wait(struct libusb_transfer * trans) {
+/* Transfers kept in flight. The ST-Link takes the next command from the
+ * OUT endpoint only when the previous one is finished and its reply read,
+ * so queued transfers complete in the order they were submitted. */
+#define STLINK_XFER_COUNT 16
+#define STLINK_EP_IN (0x01 | LIBUSB_ENDPOINT_IN)
+
+struct stlink_xfer {
+	struct libusb_transfer *trans;
+	struct trans_ctx ctx;
+	uint8_t buf[16];      /* Commands and short replies */
+	uint8_t *dest;        /* Copy the short reply here when done */
+	size_t dest_len;
+	bool status;          /* Reply of GETLASTRWSTATUS2 to check */
+	uint32_t addr;        /* Address of the block the status is for */
+};
+static struct stlink_xfer stlink_xfers[STLINK_XFER_COUNT];
+static int xfer_head;
+static int xfer_count;
+
+/* First failing status of a pipelined run and its block, the number of
+ * failing blocks and whether transfers were lost to a USB error */
+static int xfer_status;
+static uint32_t xfer_status_addr;
+static int xfer_status_fails;
+static bool xfer_aborted;
+
+static void stlink_xfer_abort(void)
+{
+	struct timeval timeout = {1, 0};
+
+	for (int i = 0; i < xfer_count; i++) {
+		struct stlink_xfer *x =
+			&stlink_xfers[(xfer_head + i) % STLINK_XFER_COUNT];
+		if (!x->ctx.flags)
+			libusb_cancel_transfer(x->trans);
+	}
+	for (int i = 0; i < xfer_count; i++) {
+		struct stlink_xfer *x =
+			&stlink_xfers[(xfer_head + i) % STLINK_XFER_COUNT];
+		while (!x->ctx.flags) {
+			if (libusb_handle_events_timeout(Stlink.libusb_ctx, &timeout))
+				break;
+		}
+	}
+	xfer_count = 0;
+	xfer_aborted = true;
+	DEBUG_USB("clear halt\n");
+	libusb_clear_halt(Stlink.handle, Stlink.ep_tx);
+	libusb_clear_halt(Stlink.handle, 1);
+}
+
+/* Wait for the oldest transfer in flight and retire it */
+static int stlink_xfer_harvest(void)
+{
+	struct stlink_xfer *x = &stlink_xfers[xfer_head];
 	struct timeval start;
 	struct timeval now;
 	struct timeval diff;
-	struct trans_ctx trans_ctx;
-	enum libusb_error error;
-
-	trans_ctx.flags = 0;
-
-	/* brief intrusion inside the libusb interface */
-	trans->callback = on_trans_done;
-	trans->user_data = &trans_ctx;
-
-	if ((error = libusb_submit_transfer(trans))) {
-		DEBUG("libusb_submit_transfer(%d): %s\n", error,
-			  libusb_strerror(error));
-		exit(-1);
-	}
 
 	gettimeofday(&start, NULL);
-
-	while (trans_ctx.flags == 0) {
+	while (x->ctx.flags == 0) {
 		struct timeval timeout;
 		timeout.tv_sec = 1;
 		timeout.tv_usec = 0;
 		if (libusb_handle_events_timeout(Stlink.libusb_ctx, &timeout)) {
 			DEBUG("libusb_handle_events()\n");
+			stlink_xfer_abort();
 			return -1;
 		}
-
 		gettimeofday(&now, NULL);
 		timersub(&now, &start, &diff);
 		if (diff.tv_sec >= 1) {
-			libusb_cancel_transfer(trans);
 			DEBUG("libusb_handle_events() timeout\n");
+			stlink_xfer_abort();
 			return -1;
 		}
 	}
-
-	if (trans_ctx.flags & TRANS_FLAGS_HAS_ERROR) {
+	if (x->ctx.flags & TRANS_FLAGS_HAS_ERROR) {
 		DEBUG("libusb_handle_events() | has_error\n");
+		stlink_xfer_abort();
 		return -1;
 	}
+	xfer_head = (xfer_head + 1) % STLINK_XFER_COUNT;
+	xfer_count--;
+	if (x->trans->endpoint == STLINK_EP_IN) {
+		int res = x->trans->actual_length;
+		DEBUG_USB(" Rec (%d/%d)", x->trans->length, res);
+		for (int i = 0; i < res && i < 32 ; i++) {
+			if ( i && ((i & 7) == 0))
+				DEBUG_USB(".");
+			DEBUG_USB("%02x", x->trans->buffer[i]);
+		}
+		DEBUG_USB("\n");
+	}
+	if (x->dest)
+		memcpy(x->dest, x->buf, x->dest_len);
+	if (x->status) {
+		int res = stlink_usb_error_check(x->buf, false);
+		if ((res != STLINK_ERROR_OK) && !xfer_status_fails++) {
+			xfer_status = res;
+			xfer_status_addr = x->addr;
+		}
+	}
+	return 0;
+}
 
+/* Wait for all transfers in flight */
+static int stlink_xfer_sync(void)
+{
+	while (xfer_count) {
+		if (stlink_xfer_harvest())
+			return -1;
+	}
 	return 0;
 }
-#define STLINK_ERROR_DP_FAULT -2
-static int send_recv(uint8_t *txbuf, size_t txsize,
-					 uint8_t *rxbuf, size_t rxsize)
+
+/* Next free slot, waiting for the oldest transfer if all are in flight */
+static struct stlink_xfer *stlink_xfer_slot(void)
 {
-	int res = 0;
-	stlink_check_detach(1);
-	if( txsize) {
-		int txlen = txsize;
-		libusb_fill_bulk_transfer(Stlink.req_trans, Stlink.handle,
-								  Stlink.ep_tx | LIBUSB_ENDPOINT_OUT,
-								  txbuf, txlen,
-								  NULL, NULL,
-								  0
-			);
-		DEBUG_USB("  Send (%d): ", txlen);
-		for (int i = 0; i < txlen && i < 32 ; i++) {
-			DEBUG_USB("%02x", txbuf[i]);
+	if ((xfer_count == STLINK_XFER_COUNT) && stlink_xfer_harvest())
+		return NULL;
+	struct stlink_xfer *x =
+		&stlink_xfers[(xfer_head + xfer_count) % STLINK_XFER_COUNT];
+	x->dest = NULL;
+	x->status = false;
+	return x;
+}
+
+/* Submit a transfer on slot x without waiting for it. buf must stay valid
+ * until the transfer is harvested, NULL uses the slot buffer. */
+static struct stlink_xfer *stlink_xfer_submit(struct stlink_xfer *x,
+	uint8_t endpoint, uint8_t *buf, size_t size)
+{
+	enum libusb_error error;
+
+	if (!x)
+		return NULL;
+	if (!buf)
+		buf = x->buf;
+	x->ctx.flags = 0;
+	libusb_fill_bulk_transfer(x->trans, Stlink.handle, endpoint, buf, size,
+							  on_trans_done, &x->ctx, 0);
+	if (endpoint != STLINK_EP_IN) {
+		DEBUG_USB("  Send (%zu): ", size);
+		for (size_t i = 0; i < size && i < 32 ; i++) {
+			DEBUG_USB("%02x", buf[i]);
 			if ((i & 7) == 7)
 				DEBUG_USB(".");
 		}
-		if (submit_wait(Stlink.req_trans)) {
-			DEBUG_USB("clear 2\n");
-			libusb_clear_halt(Stlink.handle,2);
-			return -1;
-		}
+		DEBUG_USB("\n");
+	}
+	if ((error = libusb_submit_transfer(x->trans))) {
+		DEBUG("libusb_submit_transfer(%d): %s\n", error,
+			  libusb_strerror(error));
+		exit(-1);
+	}
+	xfer_count++;
+	return x;
+}
+
+static struct stlink_xfer *stlink_xfer_send(uint8_t *buf, size_t size)
+{
+	return stlink_xfer_submit(stlink_xfer_slot(),
+							  Stlink.ep_tx | LIBUSB_ENDPOINT_OUT, buf, size);
+}
+
+static struct stlink_xfer *stlink_xfer_recv(uint8_t *buf, size_t size)
+{
+	return stlink_xfer_submit(stlink_xfer_slot(), STLINK_EP_IN, buf, size);
+}
+
+/* Queue a command from the slot buffer, so cmd may go out of scope */
+static bool stlink_xfer_cmd(const uint8_t *cmd)
+{
+	struct stlink_xfer *x = stlink_xfer_slot();
+	if (!x)
+		return false;
+	memcpy(x->buf, cmd, 16);
+	return stlink_xfer_submit(x, Stlink.ep_tx | LIBUSB_ENDPOINT_OUT,
+							  NULL, 16) != NULL;
+}
+
+/* Queue GETLASTRWSTATUS2 behind a memory block, checked when harvested */
+static void stlink_xfer_rw_status(uint32_t addr)
+{
+	uint8_t cmd[16] = {
+		STLINK_DEBUG_COMMAND,
+		STLINK_DEBUG_APIV2_GETLASTRWSTATUS2
+	};
+	if (!stlink_xfer_cmd(cmd))
+		return;
+	struct stlink_xfer *x = stlink_xfer_slot();
+	if (x) {
+		x->status = true;
+		x->addr = addr;
+		stlink_xfer_submit(x, STLINK_EP_IN, NULL, 12);
 	}
+}
+
+#define STLINK_ERROR_DP_FAULT -2
+static int send_recv(uint8_t *txbuf, size_t txsize,
+					 uint8_t *rxbuf, size_t rxsize)
+{
+	struct stlink_xfer *rx = NULL;
+
+	stlink_check_detach(1);
+	if (txsize && !stlink_xfer_send(txbuf, txsize))
+		return -1;
 	/* send_only */
 	if (rxsize != 0) {
 		/* read the response */
-		libusb_fill_bulk_transfer(Stlink.rep_trans, Stlink.handle,
-								  0x01| LIBUSB_ENDPOINT_IN,
-								  rxbuf, rxsize, NULL, NULL, 0);
-
-		if (submit_wait(Stlink.rep_trans)) {
-			DEBUG("clear 1\n");
-			libusb_clear_halt(Stlink.handle,1);
+		rx = stlink_xfer_recv(rxbuf, rxsize);
+		if (!rx)
 			return -1;
-		}
-		res = Stlink.rep_trans->actual_length;
-		if (res >0) {
-			int i;
-			uint8_t *p = rxbuf;
-			DEBUG_USB(" Rec (%zu/%d)", rxsize, res);
-			for (i = 0; i < res && i < 32 ; i++) {
-				if ( i && ((i & 7) == 0))
-					DEBUG_USB(".");
-				DEBUG_USB("%02x", p[i]);
-			}
-		}
 	}
-	DEBUG_USB("\n");
-	return res;
+	if (stlink_xfer_sync())
+		return -1;
+	return (rx) ? rx->trans->actual_length : 0;
 }
 
 /**
@@ -880,8 +1016,8 @@ void stlink_init(int argc, char **argv)
 			goto error;
 		}
 	}
-	Stlink.req_trans = libusb_alloc_transfer(0);
-	Stlink.rep_trans = libusb_alloc_transfer(0);
+	for (int i = 0; i < STLINK_XFER_COUNT; i++)
+		stlink_xfers[i].trans = libusb_alloc_transfer(0);
 	stlink_version();
 	if ((Stlink.ver_stlink < 3 && Stlink.ver_jtag < 32) ||
 		(Stlink.ver_stlink == 3 && Stlink.ver_jtag < 3)) {
@@ -905,6 +1041,8 @@ void stlink_init(int argc, char **argv)
 	}
 	stlink_leave_state();
 	stlink_resetsys();
+	if (cl_opts.opt_max_frequency)
+		max_frequency = cl_opts.opt_max_frequency;
 	if (cl_opts.opt_mode != BMP_MODE_DEBUG) {
 		ret = cl_execute(&cl_opts);
 	} else {
@@ -941,6 +1079,20 @@ bool stlink_set_freq_divisor(uint16_t divisor)
 	return true;
 }
 
+static bool stlink_set_jtag_freq_divisor(uint16_t divisor)
+{
+	uint8_t cmd[16] = {STLINK_DEBUG_COMMAND,
+					  STLINK_DEBUG_APIV2_JTAG_SET_FREQ,
+					  divisor & 0xff, divisor >> 8};
+	uint8_t data[2];
+	send_recv(cmd, 16, data, 2);
+	if (stlink_usb_error_check(data, false))
+		return false;
+	return true;
+}
+
+/* The probe reports its clocks fastest first. With max_frequency set,
+ * the fastest one up to it is used instead of the divisor'th. */
 bool stlink3_set_freq_divisor(uint16_t divisor)
 {
 	uint8_t cmd[16] = {STLINK_DEBUG_COMMAND,
@@ -950,11 +1102,20 @@ bool stlink3_set_freq_divisor(uint16_t divisor)
 	send_recv(cmd, 16, data, 52);
 	stlink_usb_error_check(data, true);
 	int size = data[8];
+	if (max_frequency) {
+		for (divisor = 0; divisor + 1 < size; divisor++) {
+			uint8_t *p = data + 12 + divisor * sizeof(uint32_t);
+			uint32_t freq = p[0] | p[1] << 8 | p[2] << 16 | p[3] << 24;
+			if (freq * 1000 <= max_frequency)
+				break;
+		}
+	}
 	if (divisor > size)
 		divisor = size;
 	uint8_t *p = data + 12 + divisor * sizeof(uint32_t);
 	uint32_t freq = p[0] | p[1] << 8 | p[2] << 16 | p[3] << 24;
 	DEBUG("Selected %" PRId32 " khz\n", freq);
+	stlink_frequency = freq * 1000;
 	cmd[1] = STLINK_APIV3_SET_COM_FREQ;
 	cmd[2] = Stlink.transport_mode;
 	cmd[3] = 0;
@@ -967,6 +1128,53 @@ bool stlink3_set_freq_divisor(uint16_t divisor)
 	return true;
 }
 
+static const struct stlink_freq *stlink_freq_select(
+	const struct stlink_freq *table, int size)
+{
+	for (int i = 0; i < size; i++)
+		if (table[i].khz * 1000 <= max_frequency)
+			return &table[i];
+	return &table[size - 1];
+}
+
+/* Set the clock of the transport entered, max_frequency if asked for */
+static void stlink_set_frequency(void)
+{
+	bool jtag = (Stlink.transport_mode == STLINK_MODE_JTAG);
+	const struct stlink_freq *f;
+
+	if (Stlink.ver_stlink == 3) {
+		stlink3_set_freq_divisor(jtag ? 4 : 2);
+		return;
+	}
+	if (!max_frequency) {
+		stlink_set_freq_divisor(1);
+		stlink_frequency = jtag ? 0 : 1800000;
+		return;
+	}
+	if (jtag) {
+		f = stlink_freq_select(stlink_jtag_freq,
+		                       sizeof(stlink_jtag_freq) / sizeof(stlink_jtag_freq[0]));
+		stlink_set_jtag_freq_divisor(f->divisor);
+	} else {
+		f = stlink_freq_select(stlink_swd_freq,
+		                       sizeof(stlink_swd_freq) / sizeof(stlink_swd_freq[0]));
+		stlink_set_freq_divisor(f->divisor);
+	}
+	stlink_frequency = f->khz * 1000;
+}
+
+void platform_max_frequency_set(uint32_t frequency)
+{
+	max_frequency = frequency;
+	stlink_set_frequency();
+}
+
+uint32_t platform_max_frequency_get(void)
+{
+	return stlink_frequency;
+}
+
 int stlink_hwversion(void)
 {
 	return Stlink.ver_stlink;
@@ -976,10 +1184,7 @@ int stlink_enter_debug_swd(void)
 {
 	stlink_leave_state();
 	Stlink.transport_mode = STLINK_MODE_SWD;
-	if (Stlink.ver_stlink == 3)
-		stlink3_set_freq_divisor(2);
-	else
-		stlink_set_freq_divisor(1);
+	stlink_set_frequency();
 	uint8_t cmd[16] = {STLINK_DEBUG_COMMAND,
 					  STLINK_DEBUG_APIV2_ENTER,
 					  STLINK_DEBUG_ENTER_SWD_NO_RESET};
@@ -993,10 +1198,7 @@ int stlink_enter_debug_jtag(void)
 {
 	stlink_leave_state();
 	Stlink.transport_mode = STLINK_MODE_JTAG;
-	if (Stlink.ver_stlink == 3)
-		stlink3_set_freq_divisor(4);
-	else
-		stlink_set_freq_divisor(1);
+	stlink_set_frequency();
 	uint8_t cmd[16] = {STLINK_DEBUG_COMMAND,
 					  STLINK_DEBUG_APIV2_ENTER,
 					  STLINK_DEBUG_ENTER_JTAG_NO_RESET};
@@ -1193,22 +1395,137 @@ static int stlink_usb_get_rw_status(bool verbose)
 	return stlink_usb_error_check(data, verbose);
 }
 
+/* Word accesses in one command, at most up to the next 1 kiB boundary
+ * the MEM-AP TAR auto-increments over. Byte accesses go by block_size. */
+#define STLINK_RW_BLOCK_SIZE 1024
+
+static size_t stlink_mem_block_len(uint32_t addr, size_t len, bool bytes)
+{
+	size_t max = STLINK_RW_BLOCK_SIZE - (addr & (STLINK_RW_BLOCK_SIZE - 1));
+	if (bytes && (max > Stlink.block_size))
+		max = Stlink.block_size;
+	return (len > max) ? max : len;
+}
+
+/* Run a memory access of any length as blocks. All blocks are queued with
+ * their status reads behind them, so the ST-Link never waits for the host
+ * between blocks. Reads are redone one block at a time with retries on
+ * WAIT from the first block that fails. Writes stop queueing at the first
+ * failing block. The blocks queued behind it have run already and are
+ * not repeated, only a lone block that got WAIT is retried. */
+static int stlink_mem_blocks(ADIv5_AP_t *ap, uint8_t type, bool write,
+							 uint32_t addr, uint8_t *buf, size_t len)
+{
+	bool bytes = (type == STLINK_DEBUG_READMEM_8BIT) ||
+		(type == STLINK_DEBUG_WRITEMEM_8BIT);
+	uint32_t start = addr;
+	size_t left = len;
+	uint8_t *p = buf;
+
+	stlink_check_detach(1);
+  run:
+	xfer_status = STLINK_ERROR_OK;
+	xfer_status_fails = 0;
+	xfer_aborted = false;
+	while (left) {
+		if (xfer_aborted || (write && (xfer_status != STLINK_ERROR_OK)))
+			break;
+		size_t length = stlink_mem_block_len(addr, left, bytes);
+		uint8_t cmd[16] = {
+			STLINK_DEBUG_COMMAND,
+			type,
+			addr & 0xff, (addr >>  8) & 0xff, (addr >> 16) & 0xff,
+			(addr >> 24) & 0xff,
+			length & 0xff, length >> 8, ap->apsel};
+		if (!stlink_xfer_cmd(cmd))
+			break;
+		if (write) {
+			if (!stlink_xfer_send(p, length))
+				break;
+		} else if (length == 1) {
+			/* Single bytes come back as two, as in openocd */
+			struct stlink_xfer *x = stlink_xfer_slot();
+			if (!x)
+				break;
+			x->dest = p;
+			x->dest_len = 1;
+			stlink_xfer_submit(x, STLINK_EP_IN, NULL, 2);
+		} else if (!stlink_xfer_recv(p, length)) {
+			break;
+		}
+		stlink_xfer_rw_status(addr);
+		left -= length;
+		addr += length;
+		p += length;
+	}
+	if (stlink_xfer_sync() || xfer_aborted) {
+		xfer_status = STLINK_ERROR_FAIL;
+		xfer_status_addr = start;
+	}
+	if (xfer_status == STLINK_ERROR_OK)
+		return STLINK_ERROR_OK;
+	if (write) {
+		/* A single block that got WAIT can be written again alone,
+		 * then carry on with the blocks not queued yet */
+		if ((xfer_status == STLINK_ERROR_WAIT) && (xfer_status_fails == 1)) {
+			uint32_t retry = xfer_status_addr;
+			size_t length = stlink_mem_block_len(retry,
+				len - (retry - start), bytes);
+			uint8_t cmd[16] = {
+				STLINK_DEBUG_COMMAND,
+				type,
+				retry & 0xff, (retry >>  8) & 0xff, (retry >> 16) & 0xff,
+				(retry >> 24) & 0xff,
+				length & 0xff, length >> 8, ap->apsel};
+			DEBUG_STLINK("Retry at 0x%08" PRIx32 "\n", retry);
+			xfer_status = write_retry(cmd, 16, buf + (retry - start), length);
+			if ((xfer_status == STLINK_ERROR_OK) && left)
+				goto run;
+		}
+		if (xfer_status != STLINK_ERROR_OK)
+			DEBUG("stlink write failed at 0x%08" PRIx32 " (%d)\n",
+				  xfer_status_addr, xfer_status);
+		return xfer_status;
+	}
+
+	DEBUG_STLINK("Redo from 0x%08" PRIx32 ": ", xfer_status_addr);
+	addr = xfer_status_addr;
+	p = buf + (addr - start);
+	left = len - (addr - start);
+	while (left) {
+		size_t length = stlink_mem_block_len(addr, left, bytes);
+		uint8_t cmd[16] = {
+			STLINK_DEBUG_COMMAND,
+			type,
+			addr & 0xff, (addr >>  8) & 0xff, (addr >> 16) & 0xff,
+			(addr >> 24) & 0xff,
+			length & 0xff, length >> 8, ap->apsel};
+		int res;
+		if (length == 1) {
+			uint8_t data[2];
+			res = read_retry(cmd, 16, data, 2);
+			*p = data[0];
+		} else {
+			res = read_retry(cmd, 16, p, length);
+		}
+		if (res != STLINK_ERROR_OK)
+			return res;
+		left -= length;
+		addr += length;
+		p += length;
+	}
+	return STLINK_ERROR_OK;
+}
+
 void stlink_readmem(ADIv5_AP_t *ap, void *dest, uint32_t src, size_t len)
 {
 	if (len == 0)
 		return;
-	size_t read_len = len;
 	uint8_t type;
 	char *CMD;
 	if (src & 1 || len & 1) {
 		CMD = "READMEM_8BIT";
 		type = STLINK_DEBUG_READMEM_8BIT;
-		if (len > Stlink.block_size) {
-			DEBUG(" Too large!\n");
-			return;
-		}
-		if (len == 1)
-			read_len ++; /* Fix read length as in openocd*/
 	} else if (src & 3 || len & 3) {
 		CMD = "READMEM_16BIT";
 		type = STLINK_DEBUG_APIV2_READMEM_16BIT;
@@ -1219,13 +1536,7 @@ void stlink_readmem(ADIv5_AP_t *ap, void *dest, uint32_t src, size_t len)
 	}
 	DEBUG_STLINK("%s len %zu addr 0x%08" PRIx32 " AP %d : ",
 				 CMD, len, src, ap->apsel);
-	uint8_t cmd[16] = {
-		STLINK_DEBUG_COMMAND,
-		type,
-		src & 0xff, (src >>  8) & 0xff, (src >> 16) & 0xff,
-		(src >> 24) & 0xff,
-		len & 0xff, len >> 8, ap->apsel};
-	int res = read_retry(cmd, 16, dest, read_len);
+	int res = stlink_mem_blocks(ap, type, false, src, dest, len);
 	if (res == STLINK_ERROR_OK) {
 		uint8_t *p = (uint8_t*)dest;
 		for (size_t i = 0; i < len ; i++) {
@@ -1253,24 +1564,7 @@ void stlink_writemem8(ADIv5_AP_t *ap, uint32_t addr, size_t len,
 		DEBUG_STLINK("%02x", buffer[t]);
 	}
 	DEBUG_STLINK("\n");
-	while (len) {
-		size_t length;
-		if (len > Stlink.block_size)
-			length = Stlink.block_size;
-		else
-			length = len;
-		uint8_t cmd[16] = {
-			STLINK_DEBUG_COMMAND,
-			STLINK_DEBUG_WRITEMEM_8BIT,
-			addr & 0xff, (addr >>  8) & 0xff, (addr >> 16) & 0xff,
-			(addr >> 24) & 0xff,
-			length & 0xff, length >> 8, ap->apsel};
-		send_recv(cmd, 16, NULL, 0);
-		send_recv((void*)buffer, length, NULL, 0);
-		stlink_usb_get_rw_status(true);
-		len -= length;
-		addr += length;
-	}
+	stlink_mem_blocks(ap, STLINK_DEBUG_WRITEMEM_8BIT, true, addr, buffer, len);
 }
 
 void stlink_writemem16(ADIv5_AP_t *ap, uint32_t addr, size_t len,
@@ -1282,15 +1576,8 @@ void stlink_writemem16(ADIv5_AP_t *ap, uint32_t addr, size_t len,
 		DEBUG_STLINK("%04x", buffer[t]);
 	}
 	DEBUG_STLINK("\n");
-	uint8_t cmd[16] = {
-		STLINK_DEBUG_COMMAND,
-		STLINK_DEBUG_APIV2_WRITEMEM_16BIT,
-		addr & 0xff, (addr >>  8) & 0xff, (addr >> 16) & 0xff,
-		(addr >> 24) & 0xff,
-		len & 0xff, len >> 8, ap->apsel};
-	send_recv(cmd, 16, NULL, 0);
-	send_recv((void*)buffer, len, NULL, 0);
-	stlink_usb_get_rw_status(true);
+	stlink_mem_blocks(ap, STLINK_DEBUG_APIV2_WRITEMEM_16BIT, true, addr,
+					  (uint8_t *)buffer, len);
 }
 
 void stlink_writemem32(ADIv5_AP_t *ap, uint32_t addr, size_t len,
@@ -1302,13 +1589,8 @@ void stlink_writemem32(ADIv5_AP_t *ap, uint32_t addr, size_t len,
 		DEBUG_STLINK("%04x", buffer[t]);
 	}
 	DEBUG_STLINK("\n");
-	uint8_t cmd[16] = {
-		STLINK_DEBUG_COMMAND,
-		STLINK_DEBUG_WRITEMEM_32BIT,
-		addr & 0xff, (addr >>  8) & 0xff, (addr >> 16) & 0xff,
-		(addr >> 24) & 0xff,
-		len & 0xff, len >> 8, ap->apsel};
-	write_retry(cmd, 16, (void*)buffer, len);
+	stlink_mem_blocks(ap, STLINK_DEBUG_WRITEMEM_32BIT, true, addr,
+					  (uint8_t *)buffer, len);
 }
 
 void stlink_regs_read(ADIv5_AP_t *ap, void *data)
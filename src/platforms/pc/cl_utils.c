@@ -31,6 +31,8 @@
 
 #include "target.h"
 #include "target_internal.h"
+#include "crc32.h"
+#include "command.h"
 
 #include "cl_utils.h"
 
@@ -113,6 +115,12 @@ static void bmp_munmap(struct mmap_data *map)
 #endif
 }
 
+/* crc32_read_fn over the mapped file, src is the offset into it */
+static void bmp_map_read(void *priv, void *dest, uint32_t src, size_t len)
+{
+	memcpy(dest, (uint8_t *)priv + src, len);
+}
+
 static void cl_help(char **argv, BMP_CL_OPTIONS_t *opt)
 {
 	printf("%s\n\n", opt->opt_idstring);
@@ -125,6 +133,13 @@ static void cl_help(char **argv, BMP_CL_OPTIONS_t *opt)
 	printf("\t-c \"string\"\t: Use ftdi dongle with type \"string\"\n");
 	printf("\t-C\t\t: Connect under reset\n");
 	printf("\t-n\t\t: Exit immediate if no device found\n");
+	printf("\t-P <num>\t: Probe side halt poll interval in ms, 0 polls\n"
+		   "\t\t\tfrom the host. Default is 1\n");
+	printf("\t-L <file>\t: Record the remote protocol session to <file>\n");
+	printf("\t-l <file>\t: Replay a recorded session instead of using a probe\n");
+	printf("\t-k <file>\t: Cache probe results in <file> for fast re-attach\n");
+	printf("\t-f <freq>[k|M]\t: Set max SWCLK/TCK frequency, \"auto\" tunes "
+		   "it at the scan\n");
 	printf("\tRun mode related options:\n");
 	printf("\t-t\t\t: Scan SWD, with no target found scan jtag and exit\n");
 	printf("\t-E\t\t: Erase flash until flash end or for given size\n");
@@ -138,6 +153,7 @@ static void cl_help(char **argv, BMP_CL_OPTIONS_t *opt)
 		"\t\t\tDefault start is 0x08000000\n");
 	printf("\t-S <num>\t: Read <num> bytes. Default is until read fails.\n");
 	printf("\t-j\t\t: Use JTAG. SWD is default.\n");
+	printf("\t-T <num>\t: Scan SWD multi-drop bus for TARGETID <num>\n");
 	printf("\t <file>\t\t: Use (binary) file <file> for flash operation\n"
 		   "\t\t\tGiven <file> writes to flash if neither -r or -V is given\n");
 	exit(0);
@@ -147,9 +163,10 @@ void cl_init(BMP_CL_OPTIONS_t *opt, int argc, char **argv)
 {
 	int c;
 	opt->opt_target_dev = 1;
+	opt->opt_halt_poll_ms = 1;
 	opt->opt_flash_start = 0x08000000;
 	opt->opt_flash_size = 16 * 1024 *1024;
-	while((c = getopt(argc, argv, "Ehv::d:s:c:CnN:tVta:S:jprR")) != -1) {
+	while((c = getopt(argc, argv, "Ehv::d:s:c:CnN:tVta:S:jpP:rRL:l:T:k:f:")) != -1) {
 		switch(c) {
 		case 'c':
 			if (optarg)
@@ -199,6 +216,43 @@ void cl_init(BMP_CL_OPTIONS_t *opt, int argc, char **argv)
 		case 'p':
 			opt->opt_tpwr = true;
 			break;
+		case 'P':
+			if (optarg)
+				opt->opt_halt_poll_ms = strtol(optarg, NULL, 0);
+			break;
+		case 'L':
+			if (optarg)
+				opt->opt_record_file = optarg;
+			break;
+		case 'l':
+			if (optarg)
+				opt->opt_replay_file = optarg;
+			break;
+		case 'k':
+			if (optarg)
+				opt->opt_cache_file = optarg;
+			break;
+		case 'f':
+			if (optarg) {
+				if (!strcmp(optarg, "auto")) {
+#if defined(PLATFORM_NO_FREQUENCY_AUTO)
+					printf("Frequency auto tuning not supported, "
+						   "ignoring -f auto\n");
+#else
+					frequency_auto = true;
+#endif
+					break;
+				}
+				if (!parse_frequency(optarg, &opt->opt_max_frequency)) {
+					printf("Unrecognized frequency %s\n", optarg);
+					exit(1);
+				}
+			}
+			break;
+		case 'T':
+			if (optarg)
+				opt->opt_targetid = strtoul(optarg, NULL, 0);
+			break;
 		case 'a':
 			if (optarg)
 				opt->opt_flash_start = strtol(optarg, NULL, 0);
@@ -267,7 +321,7 @@ int cl_execute(BMP_CL_OPTIONS_t *opt)
 	if (opt->opt_usejtag) {
 		num_targets = jtag_scan(NULL);
 	} else {
-		num_targets = adiv5_swdp_scan();
+		num_targets = adiv5_swdp_scan(opt->opt_targetid);
 	}
 	if (!num_targets) {
 		DEBUG("No target found\n");
@@ -343,6 +397,19 @@ int cl_execute(BMP_CL_OPTIONS_t *opt)
 		target_flash_done(t);
 		target_reset(t);
 	} else {
+		if ((opt->opt_mode == BMP_MODE_FLASH_VERIFY) && map.size &&
+			t->mem_crc32) {
+			/* Compare CRCs first, that needs no readback as the
+			 * probe computes the target side. */
+			uint32_t crc = crc32_mem(bmp_map_read, map.data, 0, map.size);
+			if ((generic_crc32(t, opt->opt_flash_start, map.size) == crc) &&
+				!target_check_error(t)) {
+				printf("Verify succeeded for %zu bytes\n", map.size);
+				res = 0;
+				goto free_map;
+			}
+			DEBUG("CRC mismatch, comparing data\n");
+		}
 #define WORKSIZE 1024
 		uint8_t *data = malloc(WORKSIZE);
 		if (!data) {
@@ -46,6 +46,12 @@ typedef struct BMP_CL_OPTIONS_s {
 	char *opt_cable;
 	int opt_debuglevel;
 	int opt_target_dev;
+	int opt_halt_poll_ms;
+	char *opt_record_file;
+	char *opt_replay_file;
+	uint32_t opt_targetid;
+	char *opt_cache_file;
+	uint32_t opt_max_frequency;
 	uint32_t opt_flash_start;
 	size_t opt_flash_size;
 	char     *opt_idstring;
@@ -55,4 +61,10 @@ void cl_init(BMP_CL_OPTIONS_t *opt, int argc, char **argv);
 int cl_execute(BMP_CL_OPTIONS_t *opt);
 int serial_open(BMP_CL_OPTIONS_t *opt);
 void serial_close(void);
+int serial_buffer_write(const uint8_t *data, int size);
+int serial_buffer_read(uint8_t *data, int maxsize);
+bool serial_buffer_wait(int timeout_ms);
+/* Serial connection, with optional session recording or replay */
+int session_open(BMP_CL_OPTIONS_t *opt);
+void session_close(void);
 #endif
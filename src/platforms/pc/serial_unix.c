@@ -32,6 +32,13 @@
 
 static int fd;  /* File descriptor for connection to GDB remote */
 extern int cl_debuglevel;
+
+/* Input is read in chunks of whatever has arrived, responses are framed
+ * out of this buffer. */
+static uint8_t rbuf[1024];
+static int rbuf_pos, rbuf_len;
+/* Statistics, printed on close with debug enabled */
+static unsigned long n_responses, n_syscalls;
 /* A nice routine grabbed from
  * https://stackoverflow.com/questions/6947413/how-to-open-read-and-write-from-serial-port-in-c
  */
@@ -55,6 +62,8 @@ static int set_interface_attribs(void)
 	tty.c_cc[VTIME] = 5;            // 0.5 seconds read timeout
 
 	tty.c_iflag &= ~(IXON | IXOFF | IXANY); // shut off xon/xoff ctrl
+	// no CR/NL translation or stripping, binary frames pass as is
+	tty.c_iflag &= ~(ICRNL | INLCR | IGNCR | ISTRIP | PARMRK);
 
 	tty.c_cflag |= (CLOCAL | CREAD);// ignore modem controls,
 	// enable reading
@@ -133,16 +142,32 @@ int serial_open(BMP_CL_OPTIONS_t *opt)
 
 void serial_close(void)
 {
+	if (cl_debuglevel && n_responses)
+		printf("%lu responses, %lu syscalls, %.2f per response\n",
+			   n_responses, n_syscalls, (double)n_syscalls / n_responses);
 	close(fd);
 }
 
-int platform_buffer_write(const uint8_t *data, int size)
+static void debug_dump(const char *prefix, const uint8_t *data, int size)
+{
+	printf("%s", prefix);
+	for (int i = 0; i < size; i++)
+		printf("%02x", data[i]);
+	printf("\n");
+}
+
+int serial_buffer_write(const uint8_t *data, int size)
 {
 	int s;
 
-	if (cl_debuglevel)
-		printf("%s\n",data);
+	if (cl_debuglevel) {
+		if (data[0] == REMOTE_BIN_SOM)
+			debug_dump("", data, size);
+		else
+			printf("%s\n",data);
+	}
 	s = write(fd, data, size);
+	n_syscalls++;
 	if (s < 0) {
 		fprintf(stderr, "Failed to write\n");
 		exit(-2);
@@ -151,53 +176,88 @@ int platform_buffer_write(const uint8_t *data, int size)
 	return size;
 }
 
-int platform_buffer_read(uint8_t *data, int maxsize)
+/* Get a single character, refilling the buffer with everything that is
+ * available when empty, giving up when tv has run out */
+static void serial_getc(uint8_t *c, struct timeval *tv)
 {
-	uint8_t *c;
-	int s;
-	int ret;
-	uint32_t endTime;
 	fd_set  rset;
-	struct timeval tv;
-
-	c = data;
-	tv.tv_sec = 0;
-
-	endTime = platform_time_ms() + RESP_TIMEOUT;
-	tv.tv_usec = 1000 * (endTime - platform_time_ms());
+	int ret;
 
-	/* Look for start of response */
-	do {
+	if (rbuf_pos == rbuf_len) {
 		FD_ZERO(&rset);
 		FD_SET(fd, &rset);
-
-		ret = select(fd + 1, &rset, NULL, NULL, &tv);
+		ret = select(fd + 1, &rset, NULL, NULL, tv);
+		n_syscalls++;
 		if (ret < 0) {
 			fprintf(stderr,"Failed on select\n");
 			exit(-4);
 		}
 		if(ret == 0) {
-			fprintf(stderr,"Timeout on read RESP\n");
+			fprintf(stderr,"Timeout on read\n");
+			exit(-3);
+		}
+		ret = read(fd, rbuf, sizeof(rbuf));
+		n_syscalls++;
+		if (ret <= 0) {
+			fprintf(stderr,"Failed to read\n");
 			exit(-3);
 		}
+		rbuf_pos = 0;
+		rbuf_len = ret;
+	}
+	*c = rbuf[rbuf_pos++];
+}
 
-		s = read(fd, c, 1);
-    }
-	while ((s > 0) && (*c != REMOTE_RESP));
-	/* Now collect the response */
+bool serial_buffer_wait(int timeout_ms)
+{
+	fd_set  rset;
+	struct timeval tv;
+
+	if (rbuf_pos < rbuf_len)
+		return true;
+	tv.tv_sec = timeout_ms / 1000;
+	tv.tv_usec = (timeout_ms % 1000) * 1000;
+	FD_ZERO(&rset);
+	FD_SET(fd, &rset);
+	n_syscalls++;
+	return select(fd + 1, &rset, NULL, NULL, &tv) > 0;
+}
+
+int serial_buffer_read(uint8_t *data, int maxsize)
+{
+	uint8_t *c;
+	struct timeval tv;
+
+	c = data;
+	tv.tv_sec = 0;
+	tv.tv_usec = 1000 * RESP_TIMEOUT;
+	n_responses++;
+
+	/* Look for start of response */
 	do {
-		FD_ZERO(&rset);
-		FD_SET(fd, &rset);
-		ret = select(fd + 1, &rset, NULL, NULL, &tv);
-		if (ret < 0) {
-			fprintf(stderr,"Failed on select\n");
-			exit(-4);
-		}
-		if(ret == 0) {
-			fprintf(stderr,"Timeout on read\n");
+		serial_getc(c, &tv);
+	} while ((*c != REMOTE_RESP) && (*c != REMOTE_BIN_RESP));
+
+	if (*c == REMOTE_BIN_RESP) {
+		/* Binary framed, length prefixed response */
+		uint8_t len[2];
+		serial_getc(&len[0], &tv);
+		serial_getc(&len[1], &tv);
+		int size = remote_get_u16(len);
+		if (size > maxsize) {
+			fprintf(stderr,"Response too long\n");
 			exit(-3);
 		}
-		s = read(fd, c, 1);
+		for (int i = 0; i < size; i++)
+			serial_getc(&data[i], &tv);
+		if (cl_debuglevel)
+			debug_dump("       ", data, size);
+		return size;
+	}
+
+	/* Now collect the response */
+	do {
+		serial_getc(c, &tv);
 		if (*c==REMOTE_EOM) {
 			*c = 0;
 			if (cl_debuglevel)
@@ -206,10 +266,9 @@ int platform_buffer_read(uint8_t *data, int maxsize)
 		} else {
 			c++;
 		}
-	}while ((s >= 0) && ((c - data) < maxsize));
+	} while ((c - data) < maxsize);
 
 	fprintf(stderr,"Failed to read\n");
 	exit(-3);
 	return 0;
 }
-
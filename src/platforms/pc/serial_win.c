@@ -80,9 +80,9 @@ void serial_close(void)
 	CloseHandle(hComm);
 }
 
-int platform_buffer_write(const uint8_t *data, int size)
+int serial_buffer_write(const uint8_t *data, int size)
 {
-	if (cl_debuglevel)
+	if (cl_debuglevel && (data[0] != REMOTE_BIN_SOM))
 		printf("%s\n",data);
 	int s = 0;
 
@@ -97,7 +97,23 @@ int platform_buffer_write(const uint8_t *data, int size)
 	} while (s < size);
 	return 0;
 }
-int platform_buffer_read(uint8_t *data, int maxsize)
+bool serial_buffer_wait(int timeout_ms)
+{
+	uint32_t endTime = platform_time_ms() + timeout_ms;
+	COMSTAT comStat;
+	DWORD errors;
+
+	do {
+		if (!ClearCommError(hComm, &errors, &comStat))
+			return false;
+		if (comStat.cbInQue)
+			return true;
+		Sleep(1);
+	} while (platform_time_ms() < endTime);
+	return false;
+}
+
+int serial_buffer_read(uint8_t *data, int maxsize)
 {
 	DWORD s;
 	uint8_t response = 0;
@@ -112,7 +128,36 @@ int platform_buffer_read(uint8_t *data, int maxsize)
 			fprintf(stderr,"Timeout on read RESP\n");
 			exit(-4);
 		}
-	} while (response != REMOTE_RESP);
+	} while ((response != REMOTE_RESP) && (response != REMOTE_BIN_RESP));
+	if (response == REMOTE_BIN_RESP) {
+		/* Binary framed, length prefixed response */
+		uint8_t len[2];
+		int got = 0;
+		int size = -1;
+		while ((size < 0) || (got < size)) {
+			uint8_t *p = (size < 0) ? &len[got] : &data[got];
+			if (!ReadFile(hComm, p, 1, &s, NULL)) {
+				fprintf(stderr,"Error on read\n");
+				exit(-3);
+			}
+			if (platform_time_ms() > endTime) {
+				fprintf(stderr,"Timeout on read\n");
+				exit(-4);
+			}
+			if (s == 0)
+				continue;
+			got++;
+			if ((size < 0) && (got == 2)) {
+				size = remote_get_u16(len);
+				got = 0;
+				if (size > maxsize) {
+					fprintf(stderr,"Response too long\n");
+					exit(-3);
+				}
+			}
+		}
+		return size;
+	}
 	uint8_t *c = data;
 	do {
 		if (!ReadFile(hComm, c, 1, &s, NULL)) {
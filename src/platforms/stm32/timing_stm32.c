@@ -60,3 +60,13 @@ uint32_t platform_time_ms(void)
 	return time_ms;
 }
 
+void platform_max_frequency_set(uint32_t frequency)
+{
+	swd_delay_frequency_set(rcc_ahb_frequency, frequency);
+}
+
+uint32_t platform_max_frequency_get(void)
+{
+	return swd_delay_frequency_get(rcc_ahb_frequency);
+}
+
@@ -23,8 +23,14 @@
 #include "gdb_packet.h"
 #include "swdptap.h"
 #include "jtagtap.h"
+#include "jtag_scan.h"
 #include "gdb_if.h"
 #include "version.h"
+#include "exception.h"
+#include "adiv5.h"
+#include "target.h"
+#include "target_internal.h"
+#include "crc32.h"
 #include <stdarg.h>
 
 
@@ -56,6 +62,21 @@ uint64_t remotehston(uint32_t limit, char *s)
 	return ret;
 }
 
+/* Set while a binary framed packet is processed, responses are then
+ * framed likewise */
+static bool _binary;
+
+static void _respondBin(char respCode, const uint8_t *buf, size_t len)
+/* Send binary framed response to far end */
+{
+	gdb_if_putchar(REMOTE_BIN_RESP,0);
+	gdb_if_putchar((len + 1) & 0xff,0);
+	gdb_if_putchar((len + 1) >> 8,0);
+	gdb_if_putchar(respCode,!len);
+	while (len--)
+		gdb_if_putchar(*buf++,!len);
+}
+
 static void _respond(char respCode, uint64_t param)
 
 /* Send response to far end */
@@ -64,6 +85,13 @@ static void _respond(char respCode, uint64_t param)
 	char buf[34];
 	char *p=buf;
 
+	if (_binary) {
+		uint8_t val[4];
+		remote_put_u32(val, param);
+		_respondBin(respCode, val, sizeof(val));
+		return;
+	}
+
 	gdb_if_putchar(REMOTE_RESP,0);
 	gdb_if_putchar(respCode,0);
 
@@ -80,6 +108,24 @@ static void _respond(char respCode, uint64_t param)
 	gdb_if_putchar(REMOTE_EOM,1);
 }
 
+static void _respondBuf(char respCode, const uint8_t *buf, size_t len)
+/* Send response with a data block to far end, hex encoded unless binary */
+{
+	if (_binary) {
+		_respondBin(respCode, buf, len);
+		return;
+	}
+	gdb_if_putchar(REMOTE_RESP,0);
+	gdb_if_putchar(respCode,0);
+	while (len--) {
+		uint8_t hi = *buf >> 4;
+		uint8_t lo = *buf++ & 0x0f;
+		gdb_if_putchar(NTOH(hi),0);
+		gdb_if_putchar(NTOH(lo),0);
+	}
+	gdb_if_putchar(REMOTE_EOM,1);
+}
+
 static void _respondS(char respCode, const char *s)
 /* Send response to far end */
 {
@@ -96,7 +142,22 @@ static void _respondS(char respCode, const char *s)
 	gdb_if_putchar(REMOTE_EOM,1);
 }
 
-void remotePacketProcessSWD(uint8_t i, char *packet)
+static void _swdpTransfer(uint8_t request, uint32_t value)
+{
+	bool badParity = false;
+	uint8_t ack = swdptap_transfer(request, &value, &badParity);
+	char respCode = badParity ? REMOTE_RESP_PARERR : REMOTE_RESP_OK;
+
+	if (_binary) {
+		uint8_t buf[5] = {ack};
+		remote_put_u32(&buf[1], value);
+		_respondBin(respCode, buf, sizeof(buf));
+	} else {
+		_respond(respCode, ((uint64_t)ack << 32) | value);
+	}
+}
+
+void remotePacketProcessSWD(uint16_t i, char *packet)
 {
 	uint8_t ticks;
 	uint32_t param;
@@ -138,18 +199,53 @@ void remotePacketProcessSWD(uint8_t i, char *packet)
 		_respond(REMOTE_RESP_OK, 0);
 		break;
 
+    case REMOTE_TRANSFER: /* = Transfer ================================ */
+		if (i != 12) {
+			_respond(REMOTE_RESP_ERR,REMOTE_ERROR_WRONGLEN);
+			break;
+		}
+		_swdpTransfer(remotehston(2, &packet[2]), remotehston(8, &packet[4]));
+		break;
+
     default:
 		_respond(REMOTE_RESP_ERR,REMOTE_ERROR_UNRECOGNISED);
 		break;
     }
 }
 
-void remotePacketProcessJTAG(uint8_t i, char *packet)
+static void _jtagScan(uint8_t final_tms, uint16_t ticks, const uint8_t *DI)
+{
+	uint8_t DO[REMOTE_MAX_SCAN_BYTES];
+
+	jtagtap_tdi_tdo_seq(DO, final_tms, DI, ticks);
+	_respondBuf(REMOTE_RESP_OK, DO, (ticks + 7) / 8);
+}
+
+static void _jtagDrSeq(uint8_t pre, uint8_t post, uint8_t ticks,
+					   uint16_t count, const uint8_t *DI)
+{
+	uint8_t DO[REMOTE_MAX_SCAN_BYTES];
+	jtag_dev_t dev = {.dr_prescan = pre, .dr_postscan = post};
+
+	/* One bypass bit per device, no more than a chain can hold */
+	if ((pre > JTAG_MAX_DEVS) || (post > JTAG_MAX_DEVS)) {
+		_respond(REMOTE_RESP_ERR, REMOTE_ERROR_WRONGLEN);
+		return;
+	}
+	jtag_dev_shift_dr_seq(&dev, DO, DI, ticks, count);
+	jtagtap_sync();
+	_respondBuf(REMOTE_RESP_OK, DO, count * ((ticks + 7) / 8));
+}
+
+void remotePacketProcessJTAG(uint16_t i, char *packet)
 {
 	uint32_t MS;
-	uint64_t DO;
+	uint64_t DO = 0;
 	uint8_t ticks;
 	uint64_t DI;
+	uint8_t buf[REMOTE_MAX_SCAN_BYTES];
+	uint16_t len;
+	uint32_t seqlen;
 
 	switch (packet[1]) {
     case REMOTE_INIT: /* = initialise ================================= */
@@ -177,20 +273,44 @@ void remotePacketProcessJTAG(uint8_t i, char *packet)
     case REMOTE_TDITDO_TMS: /* = TDI/TDO  ========================================= */
     case REMOTE_TDITDO_NOTMS:
 
-		if (i<5) {
+		ticks=remotehston(2,&packet[2]);
+		if ((i<5) || (ticks>64)) {
 			_respond(REMOTE_RESP_ERR,REMOTE_ERROR_WRONGLEN);
 		} else {
-			ticks=remotehston(2,&packet[2]);
 			DI=remotehston(-1,&packet[4]);
 			jtagtap_tdi_tdo_seq((void *)&DO, (packet[1]==REMOTE_TDITDO_TMS), (void *)&DI, ticks);
 
 			/* Mask extra bits on return value... */
-			DO&=(1<<(ticks+1))-1;
+			if (ticks < 64)
+				DO&=(1ULL<<ticks)-1;
 
 			_respond(REMOTE_RESP_OK, DO);
 		}
 		break;
 
+    case REMOTE_SCAN: /* = Scan of any length ========================== */
+		len=(i<8) ? 0 : (remotehston(4,&packet[4])+7)/8;
+		if ((len==0) || (len>REMOTE_MAX_SCAN_BYTES) || (i!=8+2*len)) {
+			_respond(REMOTE_RESP_ERR,REMOTE_ERROR_WRONGLEN);
+		} else {
+			for (uint16_t j=0; j<len; j++)
+				buf[j]=remotehston(2,&packet[8+2*j]);
+			_jtagScan(remotehston(2,&packet[2]), remotehston(4,&packet[4]), buf);
+		}
+		break;
+
+    case REMOTE_DR_SEQ: /* = Sequence of DR scans ====================== */
+		seqlen=(i<12) ? 0 : remotehston(4,&packet[8])*((remotehston(2,&packet[6])+7)/8);
+		if ((seqlen==0) || (seqlen>REMOTE_MAX_SCAN_BYTES) || (i!=12+2*seqlen)) {
+			_respond(REMOTE_RESP_ERR,REMOTE_ERROR_WRONGLEN);
+		} else {
+			for (uint16_t j=0; j<seqlen; j++)
+				buf[j]=remotehston(2,&packet[12+2*j]);
+			_jtagDrSeq(remotehston(2,&packet[2]), remotehston(2,&packet[4]),
+					   remotehston(2,&packet[6]), remotehston(4,&packet[8]), buf);
+		}
+		break;
+
     case REMOTE_NEXT: /* = NEXT ======================================== */
 		if (i!=4) {
 			_respond(REMOTE_RESP_ERR,REMOTE_ERROR_WRONGLEN);
@@ -206,7 +326,293 @@ void remotePacketProcessJTAG(uint8_t i, char *packet)
     }
 }
 
-void remotePacketProcessGEN(uint8_t i, char *packet)
+/* DP run on behalf of the host. Fault state is owned by the host, so it
+ * is cleared before each command and reported back with the result.
+ */
+static ADIv5_DP_t remote_dp = {
+	.dp_read = adiv5_swdp_read,
+	.error = adiv5_swdp_error,
+	.low_access = adiv5_swdp_low_access,
+	.abort = adiv5_swdp_abort,
+	.write_posted = adiv5_swdp_write_posted,
+	.fault_ack = true,
+};
+
+static ADIv5_AP_t remote_ap = {
+	.dp = &remote_dp,
+};
+
+/* The DP SELECT and AP CSW/TAR shadows of remote_dp/remote_ap stay valid
+ * only while the host runs MEM-AP transfers back to back. Any other
+ * command may change the registers behind their back. */
+static void _hlShadowCheck(uint8_t class, uint8_t cmd)
+{
+	if ((class == REMOTE_HL_PACKET) &&
+		((cmd == REMOTE_AP_MEM_READ) || (cmd == REMOTE_AP_MEM_WRITE_SIZED) ||
+		 (cmd == REMOTE_AP_MEM_WATCH) || (cmd == REMOTE_AP_MEM_CRC32) ||
+		 (cmd == REMOTE_AP_MEM_BATCH)))
+		return;
+	adiv5_dp_invalidate(&remote_dp);
+}
+
+static void _hlApSetup(uint8_t apsel, uint32_t csw)
+{
+	if (remote_ap.apsel != apsel)
+		remote_ap.shadow_valid = 0;
+	remote_ap.apsel = apsel;
+	remote_ap.packed = (csw & ADIV5_AP_CSW_ADDRINC_MASK) ==
+		ADIV5_AP_CSW_ADDRINC_PACKED;
+	remote_ap.csw = csw & ~ADIV5_AP_CSW_ADDRINC_MASK;
+}
+
+static void _respondHL(uint32_t exception, uint32_t val)
+{
+	if (exception)
+		_respond(REMOTE_RESP_ERR, REMOTE_ERROR_EXCEPTION | (exception << 8));
+	else if (remote_dp.fault)
+		_respond(REMOTE_RESP_ERR, REMOTE_ERROR_FAULT);
+	else
+		_respond(REMOTE_RESP_OK, val);
+}
+
+static void _hlDPRead(uint16_t addr)
+{
+	volatile struct exception e;
+	volatile uint32_t val = 0;
+
+	TRY_CATCH (e, EXCEPTION_ALL) {
+		val = adiv5_dp_read(&remote_dp, addr);
+	}
+	_respondHL(e.type, val);
+}
+
+static void _hlDPError(void)
+{
+	volatile struct exception e;
+	volatile uint32_t val = 0;
+
+	TRY_CATCH (e, EXCEPTION_ALL) {
+		val = adiv5_dp_error(&remote_dp);
+	}
+	_respondHL(e.type, val);
+}
+
+static void _hlLowAccess(uint8_t RnW, uint16_t addr, uint32_t value)
+{
+	volatile struct exception e;
+	volatile uint32_t val = 0;
+
+	TRY_CATCH (e, EXCEPTION_ALL) {
+		val = adiv5_dp_low_access(&remote_dp, RnW, addr, value);
+	}
+	_respondHL(e.type, val);
+}
+
+static void _hlMemRead(uint8_t apsel, uint32_t csw, uint32_t src, size_t len)
+{
+	volatile struct exception e;
+	uint32_t buf[REMOTE_MAX_MEM_BLOCK / 4];
+
+	_hlApSetup(apsel, csw);
+	TRY_CATCH (e, EXCEPTION_ALL) {
+		adiv5_mem_read(&remote_ap, buf, src, len);
+	}
+	if (e.type || remote_dp.fault)
+		_respondHL(e.type, 0);
+	else
+		_respondBuf(REMOTE_RESP_OK, (uint8_t *)buf, len);
+}
+
+static void _hlMemWrite(uint8_t apsel, uint32_t csw, enum align align,
+						uint32_t dest, const void *src, size_t len)
+{
+	volatile struct exception e;
+
+	_hlApSetup(apsel, csw);
+	TRY_CATCH (e, EXCEPTION_ALL) {
+		adiv5_mem_write_sized(&remote_ap, dest, src, len, align);
+	}
+	_respondHL(e.type, 0);
+}
+
+static void _hlMemWatch(uint8_t apsel, uint32_t csw, uint32_t addr,
+						uint32_t mask, uint16_t interval)
+{
+	volatile struct exception e;
+	volatile uint32_t val = 0;
+
+	_hlApSetup(apsel, csw);
+	while (true) {
+		TRY_CATCH (e, EXCEPTION_ALL) {
+			uint32_t word;
+			adiv5_mem_read(&remote_ap, &word, addr, sizeof(word));
+			val = word;
+		}
+		if (e.type && (e.type != EXCEPTION_TIMEOUT))
+			break;
+		if (remote_dp.fault)
+			adiv5_dp_error(&remote_dp);
+		else if (!e.type && (val & mask))
+			break;
+		/* Anything from the host ends the watch */
+		if (gdb_if_getchar_to(interval) != 0xff) {
+			e.type = 0;
+			break;
+		}
+	}
+	_respondHL(e.type, val);
+}
+
+static void _hlApRead(void *priv, void *dest, uint32_t src, size_t len)
+{
+	adiv5_mem_read(priv, dest, src, len);
+}
+
+static void _hlMemCrc32(uint8_t apsel, uint32_t csw, uint32_t base,
+						uint32_t len)
+{
+	volatile struct exception e;
+	volatile uint32_t crc = 0;
+
+	_hlApSetup(apsel, csw);
+	TRY_CATCH (e, EXCEPTION_ALL) {
+		crc = crc32_mem(_hlApRead, &remote_ap, base, len);
+	}
+	_respondHL(e.type, crc);
+}
+
+static void _hlMemBatch(uint8_t apsel, uint32_t csw,
+						struct target_mem_op *ops, size_t count)
+{
+	volatile struct exception e;
+	uint8_t buf[REMOTE_MAX_BATCH * 4];
+
+	_hlApSetup(apsel, csw);
+	TRY_CATCH (e, EXCEPTION_ALL) {
+		adiv5_mem_batch(&remote_ap, ops, count);
+	}
+	if (e.type || remote_dp.fault) {
+		_respondHL(e.type, 0);
+		return;
+	}
+	for (size_t j = 0; j < count; j++)
+		remote_put_u32(&buf[4 * j], ops[j].value);
+	_respondBuf(REMOTE_RESP_OK, buf, 4 * count);
+}
+
+/* Size and write flag of a HB access, false for a size not 1, 2 or 4 */
+static bool _hlBatchOp(struct target_mem_op *op, uint8_t size,
+					   uint32_t addr, uint32_t value)
+{
+	op->addr = addr;
+	op->value = value;
+	op->size = size & ~REMOTE_BATCH_WRITE;
+	op->write = size & REMOTE_BATCH_WRITE;
+	return (op->size == 1) || (op->size == 2) || (op->size == 4);
+}
+
+void remotePacketProcessHL(uint16_t i, char *packet)
+{
+	uint32_t len;
+	uint32_t buf[REMOTE_MAX_MEM_BLOCK / 4];
+
+	remote_dp.fault = 0;
+	switch (packet[1]) {
+    case REMOTE_DP_READ: /* = DP read ==================================== */
+		if (i != 6) {
+			_respond(REMOTE_RESP_ERR,REMOTE_ERROR_WRONGLEN);
+			break;
+		}
+		_hlDPRead(remotehston(4, &packet[2]));
+		break;
+
+    case REMOTE_DP_ERROR: /* = Read and clear sticky errors ============== */
+		_hlDPError();
+		break;
+
+    case REMOTE_LOW_ACCESS: /* = Low access ============================== */
+		if (i != 16) {
+			_respond(REMOTE_RESP_ERR,REMOTE_ERROR_WRONGLEN);
+			break;
+		}
+		_hlLowAccess(remotehston(2, &packet[2]), remotehston(4, &packet[4]),
+					 remotehston(8, &packet[8]));
+		break;
+
+    case REMOTE_AP_MEM_READ: /* = Memory block read ===================== */
+		len = remotehston(4, &packet[20]);
+		if ((i != 24) || (len > REMOTE_MAX_MEM_BLOCK)) {
+			_respond(REMOTE_RESP_ERR,REMOTE_ERROR_WRONGLEN);
+			break;
+		}
+		_hlMemRead(remotehston(2, &packet[2]), remotehston(8, &packet[4]),
+				   remotehston(8, &packet[12]), len);
+		break;
+
+    case REMOTE_AP_MEM_WRITE_SIZED: /* = Memory block write ============= */
+		len = remotehston(4, &packet[22]);
+		if ((i < 26) || (len > REMOTE_MAX_MEM_BLOCK) ||
+			(i != 26 + 2 * len)) {
+			_respond(REMOTE_RESP_ERR,REMOTE_ERROR_WRONGLEN);
+			break;
+		}
+		for (uint32_t j = 0; j < len; j++)
+			((uint8_t *)buf)[j] = remotehston(2, &packet[26 + 2 * j]);
+		_hlMemWrite(remotehston(2, &packet[2]), remotehston(8, &packet[4]),
+					remotehston(2, &packet[12]), remotehston(8, &packet[14]),
+					buf, len);
+		break;
+
+    case REMOTE_AP_MEM_WATCH: /* = Watch a word ======================== */
+		if (i != 32) {
+			_respond(REMOTE_RESP_ERR,REMOTE_ERROR_WRONGLEN);
+			break;
+		}
+		_hlMemWatch(remotehston(2, &packet[2]), remotehston(8, &packet[4]),
+					remotehston(8, &packet[12]), remotehston(8, &packet[20]),
+					remotehston(4, &packet[28]));
+		break;
+
+    case REMOTE_AP_MEM_CRC32: /* = CRC of target memory ================= */
+		if (i != 28) {
+			_respond(REMOTE_RESP_ERR,REMOTE_ERROR_WRONGLEN);
+			break;
+		}
+		_hlMemCrc32(remotehston(2, &packet[2]), remotehston(8, &packet[4]),
+					remotehston(8, &packet[12]), remotehston(8, &packet[20]));
+		break;
+
+    case REMOTE_AP_MEM_BATCH: /* = Batch of single accesses ============= */
+		len = remotehston(2, &packet[12]);
+		if ((i < 14) || (len > REMOTE_MAX_BATCH) || (i != 14 + 18 * len)) {
+			_respond(REMOTE_RESP_ERR,REMOTE_ERROR_WRONGLEN);
+			break;
+		}
+		{
+			struct target_mem_op ops[REMOTE_MAX_BATCH];
+			uint32_t j;
+			for (j = 0; j < len; j++) {
+				char *op = &packet[14 + 18 * j];
+				if (!_hlBatchOp(&ops[j], remotehston(2, op),
+								remotehston(8, &op[2]), remotehston(8, &op[10])))
+					break;
+			}
+			if (j < len) {
+				_respond(REMOTE_RESP_ERR,REMOTE_ERROR_WRONGLEN);
+				break;
+			}
+			_hlMemBatch(remotehston(2, &packet[2]), remotehston(8, &packet[4]),
+						ops, len);
+		}
+		break;
+
+    default:
+		_respond(REMOTE_RESP_ERR,REMOTE_ERROR_UNRECOGNISED);
+		break;
+    }
+}
+
+void remotePacketProcessGEN(uint16_t i, char *packet)
 
 {
 	(void)i;
@@ -233,6 +639,36 @@ void remotePacketProcessGEN(uint8_t i, char *packet)
 #endif
 		break;
 
+    case REMOTE_FEATURES:
+		_respond(REMOTE_RESP_OK,
+				 ((uint64_t)REMOTE_PROTOCOL_VERSION << 32) |
+				 REMOTE_FEATURE_HL_DP | REMOTE_FEATURE_HL_MEM |
+				 REMOTE_FEATURE_BINARY | REMOTE_FEATURE_JTAG_SCAN |
+				 REMOTE_FEATURE_HL_WATCH | REMOTE_FEATURE_HL_CRC |
+				 REMOTE_FEATURE_HL_PACKED | REMOTE_FEATURE_JTAG_DR_SEQ |
+				 REMOTE_FEATURE_SWDP_TRANSFER | REMOTE_FEATURE_HL_BATCH |
+				 REMOTE_FEATURE_FREQ);
+		break;
+
+    case REMOTE_FREQ_SET: {
+		if (i != 10) {
+			_respond(REMOTE_RESP_ERR, REMOTE_ERROR_WRONGLEN);
+			break;
+		}
+		uint32_t frequency = remotehston(8, packet + 2);
+		if (!frequency) {
+			_respond(REMOTE_RESP_ERR, REMOTE_ERROR_UNRECOGNISED);
+			break;
+		}
+		platform_max_frequency_set(frequency);
+		_respond(REMOTE_RESP_OK, 0);
+		break;
+	}
+
+    case REMOTE_FREQ_GET:
+		_respond(REMOTE_RESP_OK, platform_max_frequency_get());
+		break;
+
     case REMOTE_PWR_GET:
 #ifdef PLATFORM_HAS_POWER_SWITCH
 		_respond(REMOTE_RESP_OK,platform_target_get_power());
@@ -254,8 +690,9 @@ void remotePacketProcessGEN(uint8_t i, char *packet)
     }
 }
 
-void remotePacketProcess(uint8_t i, char *packet)
+void remotePacketProcess(uint16_t i, char *packet)
 {
+	_hlShadowCheck(packet[0], packet[1]);
 	switch (packet[0]) {
     case REMOTE_SWDP_PACKET:
 		remotePacketProcessSWD(i,packet);
@@ -269,8 +706,158 @@ void remotePacketProcess(uint8_t i, char *packet)
 		remotePacketProcessGEN(i,packet);
 		break;
 
+    case REMOTE_HL_PACKET:
+		remotePacketProcessHL(i,packet);
+		break;
+
     default: /* Oh dear, unrecognised, return an error */
 		_respond(REMOTE_RESP_ERR,REMOTE_ERROR_UNRECOGNISED);
 		break;
     }
 }
+
+void remotePacketProcessBinary(uint16_t i, uint8_t *packet)
+/* Binary framed packets, see remote.h for the layout */
+{
+	uint32_t buf[REMOTE_MAX_MEM_BLOCK / 4];
+	uint32_t param;
+	uint16_t len;
+	bool badParity;
+
+	_binary = true;
+	remote_dp.fault = 0;
+	_hlShadowCheck(packet[0], (i < 2) ? 0 : packet[1]);
+	switch ((i < 2) ? 0 : (packet[0] << 8) | packet[1]) {
+	case (REMOTE_SWDP_PACKET << 8) | REMOTE_IN_PAR:
+		if (i != 3)
+			goto wronglen;
+		badParity = swdptap_seq_in_parity(&param, packet[2]);
+		_respond(badParity ? REMOTE_RESP_PARERR : REMOTE_RESP_OK, param);
+		break;
+
+	case (REMOTE_SWDP_PACKET << 8) | REMOTE_IN:
+		if (i != 3)
+			goto wronglen;
+		_respond(REMOTE_RESP_OK, swdptap_seq_in(packet[2]));
+		break;
+
+	case (REMOTE_SWDP_PACKET << 8) | REMOTE_OUT:
+		if (i != 7)
+			goto wronglen;
+		swdptap_seq_out(remote_get_u32(&packet[3]), packet[2]);
+		_respond(REMOTE_RESP_OK, 0);
+		break;
+
+	case (REMOTE_SWDP_PACKET << 8) | REMOTE_OUT_PAR:
+		if (i != 7)
+			goto wronglen;
+		swdptap_seq_out_parity(remote_get_u32(&packet[3]), packet[2]);
+		_respond(REMOTE_RESP_OK, 0);
+		break;
+
+	case (REMOTE_SWDP_PACKET << 8) | REMOTE_TRANSFER:
+		if (i != 7)
+			goto wronglen;
+		_swdpTransfer(packet[2], remote_get_u32(&packet[3]));
+		break;
+
+	case (REMOTE_JTAG_PACKET << 8) | REMOTE_SCAN:
+		len = (i < 5) ? 0 : (remote_get_u16(&packet[3]) + 7) / 8;
+		if ((len == 0) || (len > REMOTE_MAX_SCAN_BYTES) || (i != 5 + len))
+			goto wronglen;
+		_jtagScan(packet[2], remote_get_u16(&packet[3]), &packet[5]);
+		break;
+
+	case (REMOTE_JTAG_PACKET << 8) | REMOTE_DR_SEQ:
+		if ((i < 7) || (i != 7 + (uint32_t)remote_get_u16(&packet[5]) *
+						 ((packet[4] + 7) / 8)) || (i == 7) ||
+			(i > 7 + REMOTE_MAX_SCAN_BYTES))
+			goto wronglen;
+		_jtagDrSeq(packet[2], packet[3], packet[4], remote_get_u16(&packet[5]),
+				   &packet[7]);
+		break;
+
+	case (REMOTE_HL_PACKET << 8) | REMOTE_DP_READ:
+		if (i != 4)
+			goto wronglen;
+		_hlDPRead(remote_get_u16(&packet[2]));
+		break;
+
+	case (REMOTE_HL_PACKET << 8) | REMOTE_DP_ERROR:
+		_hlDPError();
+		break;
+
+	case (REMOTE_HL_PACKET << 8) | REMOTE_LOW_ACCESS:
+		if (i != 9)
+			goto wronglen;
+		_hlLowAccess(packet[2], remote_get_u16(&packet[3]),
+					 remote_get_u32(&packet[5]));
+		break;
+
+	case (REMOTE_HL_PACKET << 8) | REMOTE_AP_MEM_READ:
+		if ((i != 13) ||
+			((len = remote_get_u16(&packet[11])) > REMOTE_MAX_MEM_BLOCK))
+			goto wronglen;
+		_hlMemRead(packet[2], remote_get_u32(&packet[3]),
+				   remote_get_u32(&packet[7]), len);
+		break;
+
+	case (REMOTE_HL_PACKET << 8) | REMOTE_AP_MEM_WRITE_SIZED:
+		if ((i < 14) ||
+			((len = remote_get_u16(&packet[12])) > REMOTE_MAX_MEM_BLOCK) ||
+			(i != 14 + len))
+			goto wronglen;
+		memcpy(buf, &packet[14], len);
+		_hlMemWrite(packet[2], remote_get_u32(&packet[3]), packet[7],
+					remote_get_u32(&packet[8]), buf, len);
+		break;
+
+	case (REMOTE_HL_PACKET << 8) | REMOTE_AP_MEM_WATCH:
+		if (i != 17)
+			goto wronglen;
+		_hlMemWatch(packet[2], remote_get_u32(&packet[3]),
+					remote_get_u32(&packet[7]), remote_get_u32(&packet[11]),
+					remote_get_u16(&packet[15]));
+		break;
+
+	case (REMOTE_HL_PACKET << 8) | REMOTE_AP_MEM_CRC32:
+		if (i != 15)
+			goto wronglen;
+		_hlMemCrc32(packet[2], remote_get_u32(&packet[3]),
+					remote_get_u32(&packet[7]), remote_get_u32(&packet[11]));
+		break;
+
+	case (REMOTE_HL_PACKET << 8) | REMOTE_AP_MEM_BATCH:
+		len = (i < 8) ? 0 : packet[7];
+		if ((i < 8) || (len > REMOTE_MAX_BATCH) || (i != 8 + 9 * len))
+			goto wronglen;
+		{
+			struct target_mem_op ops[REMOTE_MAX_BATCH];
+			for (uint16_t j = 0; j < len; j++) {
+				uint8_t *op = &packet[8 + 9 * j];
+				if (!_hlBatchOp(&ops[j], op[0], remote_get_u32(&op[1]),
+								remote_get_u32(&op[5])))
+					goto wronglen;
+			}
+			_hlMemBatch(packet[2], remote_get_u32(&packet[3]), ops, len);
+		}
+		break;
+
+	default:
+		_respond(REMOTE_RESP_ERR, REMOTE_ERROR_UNRECOGNISED);
+		break;
+
+	wronglen:
+		_respond(REMOTE_RESP_ERR, REMOTE_ERROR_WRONGLEN);
+		break;
+	}
+	_binary = false;
+}
+
+/* Answer a binary framed packet too long for the packet buffer */
+void remotePacketDropBinary(void)
+{
+	_binary = true;
+	_respond(REMOTE_RESP_ERR, REMOTE_ERROR_WRONGLEN);
+	_binary = false;
+}
@@ -44,6 +44,119 @@
  *       resp: F<PARAM> - hex value returned, bad parity.
  *             X<err>   - error occured
  *
+ *  St - swdptap_transfer
+ *         rr       - SWD request byte
+ *         vvvvvvvv - Value to write, ignored for reads
+ *       resp: K<avvvvvvvv> - ACK in bits 34:32, value read in bits 31:0.
+ *             P<avvvvvvvv> - as K, bad parity.
+ *
+ *  GF - Get protocol version and features
+ *       resp: K<vvffffffff> - protocol version (REMOTE_PROTOCOL_VERSION)
+ *             in bits 39:32, REMOTE_FEATURE_* bitmap in bits 31:0.
+ *             Probes predating this command answer E and support
+ *             only the plain ASCII S and J packets.
+ *
+ *  GC - platform_max_frequency_set
+ *         ffffffff - SWCLK/TCK frequency in Hz
+ *       resp: K
+ *
+ *  Gc - platform_max_frequency_get
+ *       resp: K<PARAM> - SWCLK/TCK frequency in Hz, 0 if not known.
+ *
+ *  JX - jtagtap_tdi_tdo_seq of any length up to REMOTE_MAX_SCAN_BYTES
+ *         ff       - Final TMS
+ *         tttt     - Ticks
+ *         followed by the TDI data, two hex digits per byte, LSB first.
+ *       resp: K<DATA> - TDO data, two hex digits per byte.
+ *
+ *  JQ - Sequence of DR scans, see jtag_dev_shift_dr_seq()
+ *         pp       - Devices ahead of the target in the chain (dr_prescan)
+ *         qq       - Devices behind it (dr_postscan)
+ *         tt       - Ticks per scan
+ *         cccc     - Number of scans
+ *         followed by the TDI data of all scans, (tt + 7) / 8 bytes each,
+ *         at most REMOTE_MAX_SCAN_BYTES in all.
+ *       resp: K<DATA> - TDO data of all scans, laid out as the TDI data.
+ *
+ *  HL - adiv5_swdp_low_access, run on the probe
+ *         rr       - RnW
+ *         aaaa     - Address (ADIV5_APnDP set for AP access)
+ *         vvvvvvvv - Value to write
+ *       e.g. HL00010400000002 : Write 0x2 to AP TAR
+ *       resp: K<PARAM> - hex value returned.
+ *             E<err>   - FAULT ACK (REMOTE_ERROR_FAULT), or an exception
+ *                        raised on the probe (REMOTE_ERROR_EXCEPTION with
+ *                        the exception type in bits 15:8).
+ *
+ *  HM - adiv5_mem_read, run on the probe
+ *         aa       - APSEL
+ *         cccccccc - AP CSW base value. ADIV5_AP_CSW_ADDRINC_PACKED in
+ *                    it marks a MEM-AP with packed transfer support
+ *                    (REMOTE_FEATURE_HL_PACKED).
+ *         tttttttt - Target address
+ *         llll     - Length, up to REMOTE_MAX_MEM_BLOCK
+ *       resp: K<DATA> - data read, two hex digits per byte.
+ *             E<err>  - as for HL
+ *
+ *  Hm - adiv5_mem_write_sized, run on the probe
+ *         aa, cccccccc, as for HM
+ *         zz       - Access size (enum align)
+ *         tttttttt, llll as for HM, followed by the data, two hex
+ *         digits per byte.
+ *       resp: K / E<err> as for HL
+ *
+ *  HW - Watch a word on the probe until a bit of the mask is set,
+ *       e.g. DHCSR S_HALT while the target runs
+ *         aa, cccccccc, tttttttt as for HM
+ *         mmmmmmmm - Mask
+ *         iiii     - Poll interval in ms
+ *       The response is only sent when (word & mask) != 0, or when the
+ *       host cancels the watch by sending REMOTE_WATCH_CANCEL. Timeouts
+ *       and FAULT ACKs, e.g. with the target in WFI or in reset, do not
+ *       end the watch.
+ *       resp: K<PARAM> - last word read.
+ *             E<err>   - as for HL
+ *
+ *  HC - CRC-32 of target memory, computed on the probe (see crc32.h)
+ *         aa, cccccccc, tttttttt as for HM
+ *         llllllll - Length
+ *       resp: K<PARAM> - CRC.
+ *             E<err>   - as for HL
+ *
+ *  HB - target_mem_access_batch, run on the probe
+ *         aa, cccccccc as for HM
+ *         nn       - Number of accesses, up to REMOTE_MAX_BATCH
+ *         followed by each access:
+ *         zz       - Size in bytes, REMOTE_BATCH_WRITE set for writes
+ *         tttttttt - Target address
+ *         vvvvvvvv - Value to write, ignored for reads
+ *       resp: K<DATA> - 32 bit value of each access, little endian, two
+ *             hex digits per byte. Writes return their value.
+ *             E<err>  - as for HL
+ *
+ * Binary framing
+ * ==============
+ *
+ * Probes reporting REMOTE_FEATURE_BINARY also accept a binary framed
+ * version of the SWD (S) and high level (H) packets, which avoids the hex
+ * encoding and the printf/parse overhead on both sides.
+ *
+ * <REMOTE_BIN_SOM><LEN><CLASS><CMD><PAYLOAD>
+ *   <LEN>     - 16 bit little endian length of CLASS, CMD and PAYLOAD
+ *   <CLASS>   - Packet class, e.g. REMOTE_HL_PACKET
+ *   <CMD>     - Command, as for the ASCII packet
+ *   <PAYLOAD> - The ASCII packet parameters in the same order, as
+ *               little endian values of the given width. Data blocks
+ *               are sent raw.
+ *
+ * The response is framed likewise:
+ *
+ * <REMOTE_BIN_RESP><LEN><CODE><DATA>
+ *   <CODE>    - Response code, as for the ASCII response
+ *   <DATA>    - The ASCII response parameter as little endian 32 bit
+ *               value, or the raw data for HM, HB, JX and JQ. St answers
+ *               with the ACK byte followed by the 32 bit value.
+ *
  * The whole protocol is defined in this header file. Parameters have
  * to be marshalled in remote.c, swdptap.c and jtagtap.c, so be
  * careful to ensure the parameter handling matches the protocol
@@ -53,11 +166,17 @@
 /* Protocol error messages */
 #define REMOTE_ERROR_UNRECOGNISED 1
 #define REMOTE_ERROR_WRONGLEN     2
+#define REMOTE_ERROR_FAULT        3
+#define REMOTE_ERROR_EXCEPTION    4
 
 /* Start and end of message identifiers */
 #define REMOTE_SOM         '!'
 #define REMOTE_EOM         '#'
 #define REMOTE_RESP        '&'
+#define REMOTE_BIN_SOM     0x02
+#define REMOTE_BIN_RESP    0x03
+/* Frame start and 16 bit length */
+#define REMOTE_BIN_HDR     3
 
 /* Generic protocol elements */
 #define REMOTE_START        'A'
@@ -66,6 +185,9 @@
 #define REMOTE_IN_PAR       'I'
 #define REMOTE_IN           'i'
 #define REMOTE_NEXT         'N'
+#define REMOTE_SCAN         'X'
+#define REMOTE_DR_SEQ       'Q'
+#define REMOTE_TRANSFER     't'
 #define REMOTE_OUT_PAR      'O'
 #define REMOTE_OUT          'o'
 #define REMOTE_PWR_SET      'P'
@@ -73,9 +195,12 @@
 #define REMOTE_RESET        'R'
 #define REMOTE_INIT         'S'
 #define REMOTE_TMS          'T'
+#define REMOTE_FEATURES     'F'
 #define REMOTE_VOLTAGE      'V'
 #define REMOTE_SRST_SET     'Z'
 #define REMOTE_SRST_GET     'z'
+#define REMOTE_FREQ_SET     'C'
+#define REMOTE_FREQ_GET     'c'
 
 /* Protocol response options */
 #define REMOTE_RESP_OK     'K'
@@ -92,6 +217,25 @@
 #define REMOTE_SRST_GET_STR (char []){ REMOTE_SOM, REMOTE_GEN_PACKET, REMOTE_SRST_GET, REMOTE_EOM, 0 }
 #define REMOTE_PWR_SET_STR (char []){ REMOTE_SOM, REMOTE_GEN_PACKET, REMOTE_PWR_SET, '%', 'c', REMOTE_EOM, 0 }
 #define REMOTE_PWR_GET_STR (char []){ REMOTE_SOM, REMOTE_GEN_PACKET, REMOTE_PWR_GET, REMOTE_EOM, 0 }
+#define REMOTE_FEATURES_STR (char []){ REMOTE_SOM, REMOTE_GEN_PACKET, REMOTE_FEATURES, REMOTE_EOM, 0 }
+#define REMOTE_FREQ_SET_STR (char []){ REMOTE_SOM, REMOTE_GEN_PACKET, REMOTE_FREQ_SET, \
+                                       '%','0','8','x',REMOTE_EOM, 0 }
+#define REMOTE_FREQ_GET_STR (char []){ REMOTE_SOM, REMOTE_GEN_PACKET, REMOTE_FREQ_GET, REMOTE_EOM, 0 }
+
+/* Protocol version and optional features, as reported by GF. Bump the
+ * version and add a feature bit with every protocol extension. */
+#define REMOTE_PROTOCOL_VERSION 9
+#define REMOTE_FEATURE_HL_DP    (1 << 0) /* Hd, He, HL */
+#define REMOTE_FEATURE_HL_MEM   (1 << 1) /* HM, Hm */
+#define REMOTE_FEATURE_BINARY   (1 << 2) /* Binary framing */
+#define REMOTE_FEATURE_JTAG_SCAN (1 << 3) /* JX */
+#define REMOTE_FEATURE_HL_WATCH (1 << 4) /* HW */
+#define REMOTE_FEATURE_HL_CRC   (1 << 5) /* HC */
+#define REMOTE_FEATURE_HL_PACKED (1 << 6) /* Packed flag in H CSW */
+#define REMOTE_FEATURE_JTAG_DR_SEQ (1 << 7) /* JQ */
+#define REMOTE_FEATURE_SWDP_TRANSFER (1 << 8) /* St */
+#define REMOTE_FEATURE_HL_BATCH (1 << 9) /* HB */
+#define REMOTE_FEATURE_FREQ     (1 << 10) /* GC, Gc */
 
 /* SWDP protocol elements */
 #define REMOTE_SWDP_PACKET 'S'
@@ -109,6 +253,9 @@
 #define REMOTE_SWDP_OUT_PAR_STR (char []){ REMOTE_SOM, REMOTE_SWDP_PACKET, REMOTE_OUT_PAR, \
                                            '%','0','2','x','%','x',REMOTE_EOM, 0 }
 
+#define REMOTE_SWDP_TRANSFER_STR (char []){ REMOTE_SOM, REMOTE_SWDP_PACKET, REMOTE_TRANSFER, \
+                                            '%','0','2','x','%','0','8','x',REMOTE_EOM, 0 }
+
 /* JTAG protocol elements */
 #define REMOTE_JTAG_PACKET 'J'
 
@@ -125,7 +272,95 @@
 #define REMOTE_JTAG_NEXT (char []){ REMOTE_SOM, REMOTE_JTAG_PACKET, REMOTE_NEXT, \
                                        '%','c','%','c',REMOTE_EOM, 0 }
 
+/* Largest scan moved by one JX command, hex encoded in both directions */
+#define REMOTE_MAX_SCAN_BYTES 256
+
+/* Data and REMOTE_EOM are appended by the caller */
+#define REMOTE_JTAG_SCAN_STR (char []){ REMOTE_SOM, REMOTE_JTAG_PACKET, REMOTE_SCAN, \
+                                        '%','0','2','x','%','0','4','x', 0 }
+
+/* As for REMOTE_JTAG_SCAN_STR */
+#define REMOTE_JTAG_DR_SEQ_STR (char []){ REMOTE_SOM, REMOTE_JTAG_PACKET, REMOTE_DR_SEQ, \
+                                          '%','0','2','x','%','0','2','x', \
+                                          '%','0','2','x','%','0','4','x', 0 }
+
+/* High level protocol elements */
+#define REMOTE_HL_PACKET   'H'
+#define REMOTE_DP_READ     'd'
+#define REMOTE_DP_ERROR    'e'
+#define REMOTE_LOW_ACCESS  'L'
+#define REMOTE_AP_MEM_READ 'M'
+#define REMOTE_AP_MEM_WRITE_SIZED 'm'
+#define REMOTE_AP_MEM_WATCH 'W'
+#define REMOTE_AP_MEM_CRC32 'C'
+#define REMOTE_AP_MEM_BATCH 'B'
+/* Sent on its own to end a HW watch */
+#define REMOTE_WATCH_CANCEL REMOTE_EOM
+
+/* Largest block moved by one memory command. Write data travels hex
+ * encoded in the request, which has to fit into the probe packet buffer.
+ */
+#define REMOTE_MAX_MEM_BLOCK 256
+
+/* Most accesses of one HB command, and the write flag in their size */
+#define REMOTE_MAX_BATCH   16
+#define REMOTE_BATCH_WRITE 0x80
+
+#define REMOTE_DP_READ_STR (char []){ REMOTE_SOM, REMOTE_HL_PACKET, REMOTE_DP_READ, \
+                                      '%','0','4','x',REMOTE_EOM, 0 }
+
+#define REMOTE_DP_ERROR_STR (char []){ REMOTE_SOM, REMOTE_HL_PACKET, REMOTE_DP_ERROR, REMOTE_EOM, 0 }
+
+#define REMOTE_LOW_ACCESS_STR (char []){ REMOTE_SOM, REMOTE_HL_PACKET, REMOTE_LOW_ACCESS, \
+                                         '%','0','2','x','%','0','4','x','%','0','8','x',REMOTE_EOM, 0 }
+
+#define REMOTE_AP_MEM_READ_STR (char []){ REMOTE_SOM, REMOTE_HL_PACKET, REMOTE_AP_MEM_READ, \
+                                          '%','0','2','x','%','0','8','x','%','0','8','x', \
+                                          '%','0','4','x',REMOTE_EOM, 0 }
+
+/* Data and REMOTE_EOM are appended by the caller */
+#define REMOTE_AP_MEM_WRITE_SIZED_STR (char []){ REMOTE_SOM, REMOTE_HL_PACKET, REMOTE_AP_MEM_WRITE_SIZED, \
+                                                 '%','0','2','x','%','0','8','x','%','0','2','x', \
+                                                 '%','0','8','x','%','0','4','x', 0 }
+
+#define REMOTE_AP_MEM_WATCH_STR (char []){ REMOTE_SOM, REMOTE_HL_PACKET, REMOTE_AP_MEM_WATCH, \
+                                           '%','0','2','x','%','0','8','x','%','0','8','x', \
+                                           '%','0','8','x','%','0','4','x',REMOTE_EOM, 0 }
+
+#define REMOTE_AP_MEM_CRC32_STR (char []){ REMOTE_SOM, REMOTE_HL_PACKET, REMOTE_AP_MEM_CRC32, \
+                                           '%','0','2','x','%','0','8','x','%','0','8','x', \
+                                           '%','0','8','x',REMOTE_EOM, 0 }
+
+/* Accesses and REMOTE_EOM are appended by the caller */
+#define REMOTE_AP_MEM_BATCH_STR (char []){ REMOTE_SOM, REMOTE_HL_PACKET, REMOTE_AP_MEM_BATCH, \
+                                           '%','0','2','x','%','0','8','x','%','0','2','x', 0 }
+
+/* Little endian payload access for binary framed packets */
+static inline void remote_put_u16(uint8_t *p, uint16_t v)
+{
+	p[0] = v & 0xff;
+	p[1] = v >> 8;
+}
+
+static inline void remote_put_u32(uint8_t *p, uint32_t v)
+{
+	remote_put_u16(p, v & 0xffff);
+	remote_put_u16(p + 2, v >> 16);
+}
+
+static inline uint16_t remote_get_u16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t remote_get_u32(const uint8_t *p)
+{
+	return remote_get_u16(p) | ((uint32_t)remote_get_u16(p + 2) << 16);
+}
+
 uint64_t remotehston(uint32_t limit, char *s);
-void remotePacketProcess(uint8_t i, char *packet);
+void remotePacketProcess(uint16_t i, char *packet);
+void remotePacketProcessBinary(uint16_t i, uint8_t *packet);
+void remotePacketDropBinary(void);
 
 #endif
@@ -244,6 +244,23 @@ void adiv5_ap_unref(ADIv5_AP_t *ap)
 void adiv5_dp_write(ADIv5_DP_t *dp, uint16_t addr, uint32_t value)
 {
 	dp->low_access(dp, ADIV5_LOW_WRITE, addr, value);
+	if (addr == ADIV5_DP_SELECT) {
+		dp->select = value;
+		dp->select_valid = true;
+	}
+}
+
+/* Check for and clear sticky errors. Where errors come back as FAULT ACK,
+ * a RDBUFF read to settle posted writes is enough to know there are none,
+ * instead of reading and clearing CTRL/STAT every time. */
+bool adiv5_dp_check_error(ADIv5_DP_t *dp)
+{
+	if (dp->fault_ack && !dp->fault) {
+		adiv5_dp_low_access(dp, ADIV5_LOW_READ, ADIV5_DP_RDBUFF, 0);
+		if (!dp->fault)
+			return false;
+	}
+	return adiv5_dp_error(dp) != 0;
 }
 
 static uint32_t adiv5_mem_read32(ADIv5_AP_t *ap, uint32_t addr)
@@ -270,12 +287,127 @@ uint64_t adiv5_ap_read_pidr(ADIv5_AP_t *ap, uint32_t addr)
 	return pidr;
 }
 
+/* Read PIDR4..7, PIDR0..3 and CIDR0..3 of a component in one transfer */
+static void adiv5_component_ids(ADIv5_AP_t *ap, uint32_t addr,
+                                uint64_t *pidr, uint32_t *cidr)
+{
+	uint32_t id[12];
+	uint32_t pidr4 = 0, pidr0 = 0;
+
+	adiv5_mem_read(ap, id, addr + PIDR4_OFFSET, sizeof(id));
+	*cidr = 0;
+	for (int i = 0; i < 4; i++) {
+		pidr4 |= (id[i] & 0xff) << (i * 8);
+		pidr0 |= (id[i + 4] & 0xff) << (i * 8);
+		*cidr |= (id[i + 8] & 0xff) << (i * 8);
+	}
+	*pidr = (uint64_t)pidr4 << 32 | pidr0;
+}
+
+#if defined(PLATFORM_HAS_PROBE_CACHE)
+/* The ROM table walk and the driver probes take hundreds of transactions.
+ * The cores they found on an AP are kept in the platform's probe cache,
+ * keyed by the DP and AP IDs. On a hit only the ID registers of these
+ * cores are read to check the cache still matches the target. */
+#define PROBE_CACHE_CORES 4
+static struct {
+	int count;
+	struct {
+		enum arm_arch arch;
+		uint32_t addr;
+		uint64_t pidr;
+		uint32_t cidr;
+	} core[PROBE_CACHE_CORES];
+} probe_cache;
+
+static void probe_cache_add(enum arm_arch arch, uint32_t addr,
+                            uint64_t pidr, uint32_t cidr)
+{
+	if (((arch != aa_cortexm) && (arch != aa_cortexa)) ||
+	    (probe_cache.count == PROBE_CACHE_CORES))
+		return;
+	probe_cache.core[probe_cache.count].arch = arch;
+	probe_cache.core[probe_cache.count].addr = addr;
+	probe_cache.core[probe_cache.count].pidr = pidr;
+	probe_cache.core[probe_cache.count].cidr = cidr;
+	probe_cache.count++;
+}
+
+static void probe_cache_key(ADIv5_AP_t *ap, char *key, size_t size)
+{
+	snprintf(key, size, "%08" PRIx32 " %08" PRIx32 " %08" PRIx32 " %02x %08"
+	         PRIx32 " %08" PRIx32, ap->dp->idcode, ap->dp->targetid,
+	         ap->dp->targetsel, ap->apsel, ap->idr, ap->base);
+}
+
+/* Value: driver probe hint, then arch:addr:pidr:cidr per core */
+static void probe_cache_store(ADIv5_AP_t *ap)
+{
+	char key[64];
+	char value[16 + PROBE_CACHE_CORES * 40];
+	int n;
+
+	if (!probe_cache.count)
+		return;
+	probe_cache_key(ap, key, sizeof(key));
+	n = snprintf(value, sizeof(value), "%u", ap->probe_hint);
+	for (int i = 0; i < probe_cache.count; i++)
+		n += snprintf(value + n, sizeof(value) - n,
+		              " %u:%08" PRIx32 ":%016" PRIx64 ":%08" PRIx32,
+		              probe_cache.core[i].arch, probe_cache.core[i].addr,
+		              probe_cache.core[i].pidr, probe_cache.core[i].cidr);
+	platform_probe_cache_put(key, value);
+}
+
+/* Run the probes cached for ap. Returns false on a miss, with nothing
+ * probed yet. */
+static bool probe_cache_replay(ADIv5_AP_t *ap)
+{
+	char key[64];
+	unsigned hint, arch;
+	uint32_t addr, cidr;
+	uint64_t pidr;
+	int n;
+
+	probe_cache.count = 0;
+	probe_cache_key(ap, key, sizeof(key));
+	const char *value = platform_probe_cache_get(key);
+	if (!value || (sscanf(value, "%u%n", &hint, &n) != 1))
+		return false;
+	for (value += n; sscanf(value, " %u:%" SCNx32 ":%" SCNx64 ":%" SCNx32 "%n",
+	                        &arch, &addr, &pidr, &cidr, &n) == 4; value += n)
+		probe_cache_add(arch, addr, pidr, cidr);
+
+	for (int i = 0; i < probe_cache.count; i++) {
+		adiv5_component_ids(ap, probe_cache.core[i].addr, &pidr, &cidr);
+		if (adiv5_dp_error(ap->dp) || (pidr != probe_cache.core[i].pidr) ||
+		    (cidr != probe_cache.core[i].cidr)) {
+			DEBUG("AP %d: Probe cache stale\n", ap->apsel);
+			probe_cache.count = 0;
+			return false;
+		}
+	}
+	if (!probe_cache.count)
+		return false;
+	DEBUG("AP %d: Probe cache hit\n", ap->apsel);
+	ap->probe_hint = hint;
+	for (int i = 0; i < probe_cache.count; i++) {
+		if (probe_cache.core[i].arch == aa_cortexm)
+			cortexm_probe(ap, false);
+		else
+			cortexa_probe(ap, probe_cache.core[i].addr);
+	}
+	return true;
+}
+#endif
+
 static bool adiv5_component_probe(ADIv5_AP_t *ap, uint32_t addr, int recursion, int num_entry)
 {
 	(void) num_entry;
 	addr &= ~3;
-	uint64_t pidr = adiv5_ap_read_pidr(ap, addr);
-	uint32_t cidr = adiv5_ap_read_id(ap, addr + CIDR0_OFFSET);
+	uint64_t pidr;
+	uint32_t cidr;
+	adiv5_component_ids(ap, addr, &pidr, &cidr);
 	bool res = false;
 #if defined(ENABLE_DEBUG) && defined(PLATFORM_HAS_DEBUG)
 	char indent[recursion + 1];
@@ -372,6 +504,9 @@ static bool adiv5_component_probe(ADIv5_AP_t *ap, uint32_t addr, int recursion,
 					      cidc_debug_strings[pidr_pn_bits[i].cidc]);
 				}
 				res = true;
+#if defined(PLATFORM_HAS_PROBE_CACHE)
+				probe_cache_add(pidr_pn_bits[i].arch, addr, pidr, cidr);
+#endif
 				switch (pidr_pn_bits[i].arch) {
 				case aa_cortexm:
 					DEBUG("%s-> cortexm_probe\n", indent + 1);
@@ -432,8 +567,18 @@ ADIv5_AP_t *adiv5_new_ap(ADIv5_DP_t *dp, uint8_t apsel)
 		ap->csw &= ~ADIV5_AP_CSW_TRINPROG;
 	}
 
-	DEBUG("AP %3d: IDR=%08"PRIx32" CFG=%08"PRIx32" BASE=%08"PRIx32" CSW=%08"PRIx32"\n",
-	      apsel, ap->idr, ap->cfg, ap->base, ap->csw);
+	/* Packed transfers are optional, AddrInc only reads back as packed
+	 * where they are implemented. */
+	if ((ap->idr & ADIV5_AP_IDR_CLASS_MASK) == ADIV5_AP_IDR_CLASS_MEM) {
+		adiv5_ap_write(ap, ADIV5_AP_CSW, ap->csw |
+		               ADIV5_AP_CSW_ADDRINC_PACKED | ADIV5_AP_CSW_SIZE_BYTE);
+		ap->packed = (adiv5_ap_read(ap, ADIV5_AP_CSW) &
+		              ADIV5_AP_CSW_ADDRINC_MASK) == ADIV5_AP_CSW_ADDRINC_PACKED;
+		adiv5_ap_write(ap, ADIV5_AP_CSW, ap->csw);
+	}
+
+	DEBUG("AP %3d: IDR=%08"PRIx32" CFG=%08"PRIx32" BASE=%08"PRIx32" CSW=%08"PRIx32"%s\n",
+	      apsel, ap->idr, ap->cfg, ap->base, ap->csw, ap->packed ? " packed" : "");
 	return ap;
 }
 
@@ -544,7 +689,17 @@ void adiv5_dp_init(ADIv5_DP_t *dp)
 		 */
 
 		/* The rest should only be added after checking ROM table */
+#if defined(PLATFORM_HAS_PROBE_CACHE)
+		if (probe_cache_replay(ap)) {
+			probe_cache_store(ap);
+			probed = true;
+			continue;
+		}
+#endif
 		probed |= adiv5_component_probe(ap, ap->base, 0, 0);
+#if defined(PLATFORM_HAS_PROBE_CACHE)
+		probe_cache_store(ap);
+#endif
 		if (!probed && (dp->idcode & 0xfff) == 0x477) {
 			DEBUG("-> cortexm_probe forced\n");
 			cortexm_probe(ap, true);
@@ -557,15 +712,78 @@ void adiv5_dp_init(ADIv5_DP_t *dp)
 #define ALIGNOF(x) (((x) & 3) == 0 ? ALIGN_WORD : \
                     (((x) & 1) == 0 ? ALIGN_HALFWORD : ALIGN_BYTE))
 
+/* Split a transfer into an unaligned head, a word aligned body and an
+ * unaligned tail. Returns the widest access size usable at addr and the
+ * number of bytes to transfer with it in count. */
+static enum align mem_segment(uint32_t addr, size_t len, size_t *count)
+{
+	enum align align = ALIGNOF(addr);
+
+	while ((1u << align) > len)
+		align--;
+	*count = (align == ALIGN_WORD) ? (len & ~3) : (1u << align);
+	return align;
+}
+
 #if !defined(JTAG_HL)
 
 bool adiv5_ap_setup(int i) {(void)i; return true;}
 void adiv5_ap_cleanup(int i) {(void)i;}
 
-/* Program the CSW and TAR for sequencial access at a given width */
-static void ap_mem_access_setup(ADIv5_AP_t *ap, uint32_t addr, enum align align)
+#define AP_SHADOW_CSW (1 << 0)
+#define AP_SHADOW_TAR (1 << 1)
+
+/* Return the shadow for CSW or TAR if it is known to hold value */
+static bool ap_shadow_hit(ADIv5_AP_t *ap, uint16_t addr, uint32_t value)
+{
+	if (ap->shadow_gen != ap->dp->shadow_gen)
+		return false;
+	if (addr == ADIV5_AP_CSW)
+		return (ap->shadow_valid & AP_SHADOW_CSW) && (ap->csw_shadow == value);
+	if (addr == ADIV5_AP_TAR)
+		return (ap->shadow_valid & AP_SHADOW_TAR) && (ap->tar_shadow == value);
+	return false;
+}
+
+static void ap_shadow_set(ADIv5_AP_t *ap, uint16_t addr, uint32_t value)
+{
+	if (ap->shadow_gen != ap->dp->shadow_gen) {
+		ap->shadow_gen = ap->dp->shadow_gen;
+		ap->shadow_valid = 0;
+	}
+	if (addr == ADIV5_AP_CSW) {
+		ap->csw_shadow = value;
+		ap->shadow_valid |= AP_SHADOW_CSW;
+	} else if (addr == ADIV5_AP_TAR) {
+		ap->tar_shadow = value;
+		ap->shadow_valid |= AP_SHADOW_TAR;
+	}
+}
+
+/* Point DP SELECT at the register bank of addr on this AP */
+static void ap_select(ADIv5_AP_t *ap, uint16_t addr)
+{
+	uint32_t select = ((uint32_t)ap->apsel << 24) | (addr & 0xF0);
+
+	if (ap->dp->select_valid && (ap->dp->select == select))
+		return;
+	adiv5_dp_write(ap->dp, ADIV5_DP_SELECT, select);
+}
+
+/* Program the CSW and TAR for access to count units at a given width,
+ * or to count words of packed units. Single accesses leave TAR alone, so
+ * polling a register needs neither CSW nor TAR to be rewritten.
+ * Returns true if TAR increments. */
+static bool ap_mem_access_setup(ADIv5_AP_t *ap, uint32_t addr, enum align align,
+                                size_t count, bool packed)
 {
-	uint32_t csw = ap->csw | ADIV5_AP_CSW_ADDRINC_SINGLE;
+	uint32_t csw = ap->csw;
+	bool incr = packed || (count > 1);
+
+	if (packed)
+		csw |= ADIV5_AP_CSW_ADDRINC_PACKED;
+	else if (incr)
+		csw |= ADIV5_AP_CSW_ADDRINC_SINGLE;
 
 	switch (align) {
 	case ALIGN_BYTE:
@@ -580,7 +798,19 @@ static void ap_mem_access_setup(ADIv5_AP_t *ap, uint32_t addr, enum align align)
 		break;
 	}
 	adiv5_ap_write(ap, ADIV5_AP_CSW, csw);
-	adiv5_dp_low_access(ap->dp, ADIV5_LOW_WRITE, ADIV5_AP_TAR, addr);
+	adiv5_ap_write(ap, ADIV5_AP_TAR, addr);
+	/* DRW is accessed directly from here on */
+	ap_select(ap, ADIV5_AP_DRW);
+	if (incr)
+		ap->shadow_valid &= ~AP_SHADOW_TAR;
+	return incr;
+}
+
+/* TAR has moved on to end, unless it wrapped at a 1 KiB boundary */
+static void ap_mem_access_done(ADIv5_AP_t *ap, uint32_t end, bool incr)
+{
+	if (incr && (end & 0x3ff))
+		ap_shadow_set(ap, ADIV5_AP_TAR, end);
 }
 
 /* Extract read data from data lane based on align and src address */
@@ -601,17 +831,83 @@ static void * extract(void *dest, uint32_t src, uint32_t val, enum align align)
 	return (uint8_t *)dest + (1 << align);
 }
 
-void adiv5_mem_read(ADIv5_AP_t *ap, void *dest, uint32_t src, size_t len)
+#define DP_CTRLSTAT_POWERUP \
+	(ADIV5_DP_CTRLSTAT_CSYSPWRUPREQ | ADIV5_DP_CTRLSTAT_CDBGPWRUPREQ)
+
+static void ap_drw_write(ADIv5_DP_t *dp, bool stream, uint16_t addr,
+                         uint32_t value)
+{
+	if (stream)
+		dp->write_posted(dp, addr, value);
+	else
+		adiv5_dp_low_access(dp, ADIV5_LOW_WRITE, addr, value);
+}
+
+/* End a burst of posted writes, returns false if it overran */
+static bool ap_mem_stream_end(ADIv5_DP_t *dp)
+{
+	uint32_t ctrlstat = adiv5_dp_read(dp, ADIV5_DP_CTRLSTAT);
+
+	if (dp->fault_ack) {
+		if (ctrlstat & ADIV5_DP_CTRLSTAT_STICKYORUN)
+			adiv5_dp_error(dp);
+		adiv5_dp_write(dp, ADIV5_DP_CTRLSTAT, DP_CTRLSTAT_POWERUP);
+		/* Leave bus errors to the next error check */
+		if (ctrlstat & ADIV5_DP_CTRLSTAT_STICKYERR)
+			dp->fault = 1;
+	} else {
+		/* JTAG-DP clears sticky flags by writing them to CTRL/STAT.
+		 * Clear the overrun alone, STICKYERR stays set for the next
+		 * error check. fault is not ours here, it shares dev. */
+		adiv5_dp_write(dp, ADIV5_DP_CTRLSTAT, DP_CTRLSTAT_POWERUP |
+		               (ctrlstat & ADIV5_DP_CTRLSTAT_STICKYORUN));
+	}
+	return !(ctrlstat & ADIV5_DP_CTRLSTAT_STICKYORUN);
+}
+
+/* Read a burst with the DP's read_burst, in runs that end at a TAR wrap.
+ * The DP detects overruns, returns false if one happened. */
+#define AP_READ_BURST_MAX 64
+static bool ap_mem_read_stream(ADIv5_AP_t *ap, void *dest, uint32_t src,
+                               size_t len, enum align align)
+{
+	uint32_t values[AP_READ_BURST_MAX];
+
+	len >>= align;
+	bool incr = ap_mem_access_setup(ap, src, align, len, false);
+	adiv5_dp_write(ap->dp, ADIV5_DP_CTRLSTAT,
+	               DP_CTRLSTAT_POWERUP | ADIV5_DP_CTRLSTAT_ORUNDETECT);
+	while (len) {
+		size_t count = MIN(len, (0x400 - (src & 0x3ff)) >> align);
+		count = MIN(count, AP_READ_BURST_MAX);
+		ap->dp->read_burst(ap->dp, ADIV5_AP_DRW, values, count);
+		for (size_t i = 0; i < count; i++) {
+			dest = extract(dest, src, values[i], align);
+			src += (1 << align);
+		}
+		len -= count;
+		/* TAR only increments within 1 KiB */
+		if (len && !(src & 0x3ff))
+			adiv5_dp_low_access(ap->dp, ADIV5_LOW_WRITE, ADIV5_AP_TAR, src);
+	}
+	if (!ap_mem_stream_end(ap->dp))
+		return false;
+	ap_mem_access_done(ap, src, incr);
+	return true;
+}
+
+static void ap_mem_read_sized(ADIv5_AP_t *ap, void *dest, uint32_t src,
+                              size_t len, enum align align)
 {
 	uint32_t tmp;
 	uint32_t osrc = src;
-	enum align align = MIN(ALIGNOF(src), ALIGNOF(len));
 
-	if (len == 0)
+	/* Repeat a burst that overran waiting for each read */
+	if (ap->dp->read_burst && ((len >> align) > 1) &&
+		ap_mem_read_stream(ap, dest, src, len, align))
 		return;
-
 	len >>= align;
-	ap_mem_access_setup(ap, src, align);
+	bool incr = ap_mem_access_setup(ap, src, align, len, false);
 	adiv5_dp_low_access(ap->dp, ADIV5_LOW_READ, ADIV5_AP_DRW, 0);
 	while (--len) {
 		tmp = adiv5_dp_low_access(ap->dp, ADIV5_LOW_READ, ADIV5_AP_DRW, 0);
@@ -629,19 +925,47 @@ void adiv5_mem_read(ADIv5_AP_t *ap, void *dest, uint32_t src, size_t len)
 	}
 	tmp = adiv5_dp_low_access(ap->dp, ADIV5_LOW_READ, ADIV5_DP_RDBUFF, 0);
 	extract(dest, src, tmp, align);
+	ap_mem_access_done(ap, src + (1 << align), incr);
 }
 
-void adiv5_mem_write_sized(ADIv5_AP_t *ap, uint32_t dest, const void *src,
-					  size_t len, enum align align)
+void adiv5_mem_read(ADIv5_AP_t *ap, void *dest, uint32_t src, size_t len)
+{
+	if (len == 0)
+		return;
+	if (ap->dp->mem_read) {
+		ap->dp->mem_read(ap, dest, src, len);
+		return;
+	}
+	while (len) {
+		size_t count;
+		enum align align = mem_segment(src, len, &count);
+		ap_mem_read_sized(ap, dest, src, count, align);
+		dest = (uint8_t *)dest + count;
+		src += count;
+		len -= count;
+	}
+}
+
+/* Packed transfers move a whole word of bytes or halfwords per DRW
+ * write, the data is laid out as in memory. A stream does not wait for
+ * the ACK of each write but has the DP detect overruns, returns false
+ * if one happened. */
+static bool ap_mem_write_run(ADIv5_AP_t *ap, uint32_t dest, const void *src,
+                             size_t len, enum align align, bool packed,
+                             bool stream)
 {
 	uint32_t odest = dest;
+	enum align lane = packed ? ALIGN_WORD : align;
 
-	len >>= align;
-	ap_mem_access_setup(ap, dest, align);
+	len >>= lane;
+	bool incr = ap_mem_access_setup(ap, dest, align, len, packed);
+	if (stream)
+		adiv5_dp_write(ap->dp, ADIV5_DP_CTRLSTAT,
+		               DP_CTRLSTAT_POWERUP | ADIV5_DP_CTRLSTAT_ORUNDETECT);
 	while (len--) {
 		uint32_t tmp = 0;
 		/* Pack data into correct data lane */
-		switch (align) {
+		switch (lane) {
 		case ALIGN_BYTE:
 			tmp = ((uint32_t)*(uint8_t *)src) << ((dest & 3) << 3);
 			break;
@@ -653,31 +977,66 @@ void adiv5_mem_write_sized(ADIv5_AP_t *ap, uint32_t dest, const void *src,
 			tmp = *(uint32_t *)src;
 			break;
 		}
-		src = (uint8_t *)src + (1 << align);
-		dest += (1 << align);
-		adiv5_dp_low_access(ap->dp, ADIV5_LOW_WRITE, ADIV5_AP_DRW, tmp);
+		src = (uint8_t *)src + (1 << lane);
+		dest += (1 << lane);
+		ap_drw_write(ap->dp, stream, ADIV5_AP_DRW, tmp);
 
 		/* Check for 10 bit address overflow */
 		if ((dest ^ odest) & 0xfffffc00) {
 			odest = dest;
-			adiv5_dp_low_access(ap->dp,
-					ADIV5_LOW_WRITE, ADIV5_AP_TAR, dest);
+			ap_drw_write(ap->dp, stream, ADIV5_AP_TAR, dest);
 		}
 	}
+	if (stream && !ap_mem_stream_end(ap->dp))
+		return false;
+	ap_mem_access_done(ap, dest, incr);
+	return true;
+}
+
+static void ap_mem_write_sized(ADIv5_AP_t *ap, uint32_t dest, const void *src,
+                               size_t len, enum align align, bool packed)
+{
+	enum align lane = packed ? ALIGN_WORD : align;
+
+	/* Stream bursts, repeat one that overran waiting for each ACK */
+	if (ap->dp->write_posted && ((len >> lane) > 1) &&
+		ap_mem_write_run(ap, dest, src, len, align, packed, true))
+		return;
+	ap_mem_write_run(ap, dest, src, len, align, packed, false);
+}
+
+void adiv5_mem_write_sized(ADIv5_AP_t *ap, uint32_t dest, const void *src,
+					  size_t len, enum align align)
+{
+	if (ap->dp->mem_write_sized) {
+		ap->dp->mem_write_sized(ap, dest, src, len, align);
+		return;
+	}
+	if (ap->packed && (align < ALIGN_WORD) && !(dest & 3) && (len >= 4)) {
+		size_t words = len & ~3;
+		ap_mem_write_sized(ap, dest, src, words, align, true);
+		src = (const uint8_t *)src + words;
+		dest += words;
+		len -= words;
+	}
+	if (len)
+		ap_mem_write_sized(ap, dest, src, len, align, false);
 }
 
 void adiv5_ap_write(ADIv5_AP_t *ap, uint16_t addr, uint32_t value)
 {
-	adiv5_dp_write(ap->dp, ADIV5_DP_SELECT,
-			((uint32_t)ap->apsel << 24)|(addr & 0xF0));
+	/* Select even on a hit, callers may go on with raw DP accesses */
+	ap_select(ap, addr);
+	if (ap_shadow_hit(ap, addr, value))
+		return;
 	adiv5_dp_write(ap->dp, addr, value);
+	ap_shadow_set(ap, addr, value);
 }
 
 uint32_t adiv5_ap_read(ADIv5_AP_t *ap, uint16_t addr)
 {
 	uint32_t ret;
-	adiv5_dp_write(ap->dp, ADIV5_DP_SELECT,
-			((uint32_t)ap->apsel << 24)|(addr & 0xF0));
+	ap_select(ap, addr);
 	ret = adiv5_dp_read(ap->dp, addr);
 	return ret;
 }
@@ -685,6 +1044,32 @@ uint32_t adiv5_ap_read(ADIv5_AP_t *ap, uint16_t addr)
 
 void adiv5_mem_write(ADIv5_AP_t *ap, uint32_t dest, const void *src, size_t len)
 {
-	enum align align = MIN(ALIGNOF(dest), ALIGNOF(len));
-	adiv5_mem_write_sized(ap, dest, src, len, align);
+	while (len) {
+		size_t count;
+		enum align align = mem_segment(dest, len, &count);
+		adiv5_mem_write_sized(ap, dest, src, count, align);
+		src = (const uint8_t *)src + count;
+		dest += count;
+		len -= count;
+	}
+}
+
+/* Run the single accesses of target_mem_access_batch(), in one go where
+ * the transport can. Errors are left to the caller's check. */
+void adiv5_mem_batch(ADIv5_AP_t *ap, struct target_mem_op *ops, size_t count)
+{
+	if (ap->dp->mem_batch) {
+		ap->dp->mem_batch(ap, ops, count);
+		return;
+	}
+	for (size_t i = 0; i < count; i++) {
+		enum align align = ops[i].size >> 1;
+		if (ops[i].write) {
+			adiv5_mem_write_sized(ap, ops[i].addr, &ops[i].value,
+			                      ops[i].size, align);
+		} else {
+			ops[i].value = 0;
+			adiv5_mem_read(ap, &ops[i].value, ops[i].addr, ops[i].size);
+		}
+	}
 }
@@ -33,6 +33,7 @@
 #define ADIV5_DP_CTRLSTAT ADIV5_DP_REG(0x4)
 #define ADIV5_DP_SELECT   ADIV5_DP_REG(0x8)
 #define ADIV5_DP_RDBUFF   ADIV5_DP_REG(0xC)
+#define ADIV5_DP_TARGETSEL ADIV5_DP_REG(0xC) /* SW-DP v2, write only */
 
 #define ADIV5_DP_BANK0    0
 #define ADIV5_DP_BANK1    1
@@ -44,6 +45,10 @@
 #define ADIV5_DPv1            0x1000
 #define ADIV5_DPv2            0x2000
 
+/* TARGETSEL is TARGETID with the TINSTANCE of DLPIDR in the top bits */
+#define ADIV5_DP_TINSTANCE_MASK  0xf0000000
+#define ADIV5_DP_TINSTANCE_SHIFT 28
+
 /* AP Abort Register (ABORT) */
 /* Bits 31:5 - Reserved */
 #define ADIV5_DP_ABORT_ORUNERRCLR	(1 << 4)
@@ -86,6 +91,10 @@
 #define ADIV5_AP_BASE		ADIV5_AP_REG(0xF8)
 #define ADIV5_AP_IDR		ADIV5_AP_REG(0xFC)
 
+/* AP Identification Register (IDR) */
+#define ADIV5_AP_IDR_CLASS_MASK		(0xFu << 13)
+#define ADIV5_AP_IDR_CLASS_MEM		(0x8u << 13)
+
 /* AP Control and Status Word (CSW) */
 #define ADIV5_AP_CSW_DBGSWENABLE	(1u << 31)
 /* Bits 30:24 - Prot, Implementation defined, for Cortex-M3: */
@@ -129,6 +138,9 @@ enum align {
 	ALIGN_DWORD    = 3
 };
 
+struct ADIv5_AP_s;
+struct target_mem_op;
+
 /* Try to keep this somewhat absract for later adding SW-DP */
 typedef struct ADIv5_DP_s {
 	int refcnt;
@@ -136,19 +148,59 @@ typedef struct ADIv5_DP_s {
 	uint32_t idcode;
 	uint32_t dp_idcode; /* Contains DPvX revision*/
 	uint32_t targetid;  /* Contains IDCODE for DPv2 devices.*/
+	uint32_t targetsel; /* Selects this DP on a multi-drop bus, else 0 */
 
 	uint32_t (*dp_read)(struct ADIv5_DP_s *dp, uint16_t addr);
 	uint32_t (*error)(struct ADIv5_DP_s *dp);
 	uint32_t (*low_access)(struct ADIv5_DP_s *dp, uint8_t RnW,
                                uint16_t addr, uint32_t value);
 	void (*abort)(struct ADIv5_DP_s *dp, uint32_t abort);
+	/* Optional, write without waiting for the ACK. Only used in bursts
+	 * with ORUNDETECT set, overruns are checked at their end. */
+	void (*write_posted)(struct ADIv5_DP_s *dp, uint16_t addr,
+	                     uint32_t value);
+	/* Optional, count reads of an AP register in one go, each result in
+	 * its own slot. Used in the same bursts as write_posted. */
+	void (*read_burst)(struct ADIv5_DP_s *dp, uint16_t addr,
+	                   uint32_t *values, size_t count);
+
+	/* Optional, whole MEM-AP transfers done by the transport */
+	void (*mem_read)(struct ADIv5_AP_s *ap, void *dest, uint32_t src,
+	                 size_t len);
+	void (*mem_write_sized)(struct ADIv5_AP_s *ap, uint32_t dest,
+	                        const void *src, size_t len, enum align align);
+	/* Optional, have the transport watch a word until (word & mask) != 0.
+	 * Returns false while still waiting. */
+	bool (*mem_watch)(struct ADIv5_AP_s *ap, uint32_t addr, uint32_t mask);
+	/* Optional, CRC-32 over target memory computed by the transport */
+	uint32_t (*mem_crc32)(struct ADIv5_AP_s *ap, uint32_t base, size_t len);
+	/* Optional, a list of single accesses run by the transport */
+	void (*mem_batch)(struct ADIv5_AP_s *ap, struct target_mem_op *ops,
+	                  size_t count);
 
 	union {
 		jtag_dev_t *dev;
 		uint8_t fault;
 	};
+	/* Sticky errors are reported as FAULT ACK and tracked in fault (SW-DP) */
+	bool fault_ack;
+
+	/* Shadow of DP SELECT, to skip rewriting an unchanged value */
+	uint32_t select;
+	bool select_valid;
+	/* Bumped to drop the CSW/TAR shadows of all APs on this DP */
+	uint32_t shadow_gen;
 } ADIv5_DP_t;
 
+/* Forget the shadowed SELECT, CSW and TAR values. Used when the
+ * registers may have changed behind our back: errors, aborts, resets
+ * and transfers run by the transport itself. */
+static inline void adiv5_dp_invalidate(ADIv5_DP_t *dp)
+{
+	dp->select_valid = false;
+	dp->shadow_gen++;
+}
+
 static inline uint32_t adiv5_dp_read(ADIv5_DP_t *dp, uint16_t addr)
 {
 	return dp->dp_read(dp, addr);
@@ -156,6 +208,8 @@ static inline uint32_t adiv5_dp_read(ADIv5_DP_t *dp, uint16_t addr)
 
 static inline uint32_t adiv5_dp_error(ADIv5_DP_t *dp)
 {
+	/* Writes are dropped while a sticky error is set */
+	adiv5_dp_invalidate(dp);
 	return dp->error(dp);
 }
 
@@ -167,6 +221,7 @@ static inline uint32_t adiv5_dp_low_access(struct ADIv5_DP_s *dp, uint8_t RnW,
 
 static inline void adiv5_dp_abort(struct ADIv5_DP_s *dp, uint32_t abort)
 {
+	adiv5_dp_invalidate(dp);
 	return dp->abort(dp, abort);
 }
 
@@ -180,10 +235,22 @@ typedef struct ADIv5_AP_s {
 	uint32_t cfg;
 	uint32_t base;
 	uint32_t csw;
+	/* MEM-AP implements ADIV5_AP_CSW_ADDRINC_PACKED */
+	bool packed;
+	/* 1 + index of the target driver probe that matched, 0 if none */
+	uint8_t probe_hint;
+
+	/* Shadows of the CSW and TAR registers, valid as flagged in
+	 * shadow_valid while shadow_gen matches the DP's */
+	uint32_t csw_shadow;
+	uint32_t tar_shadow;
+	uint8_t shadow_valid;
+	uint32_t shadow_gen;
 } ADIv5_AP_t;
 
 void adiv5_dp_init(ADIv5_DP_t *dp);
 void adiv5_dp_write(ADIv5_DP_t *dp, uint16_t addr, uint32_t value);
+bool adiv5_dp_check_error(ADIv5_DP_t *dp);
 
 ADIv5_AP_t *adiv5_new_ap(ADIv5_DP_t *dp, uint8_t apsel);
 void adiv5_ap_ref(ADIv5_AP_t *ap);
@@ -194,9 +261,19 @@ uint32_t adiv5_ap_read(ADIv5_AP_t *ap, uint16_t addr);
 
 void adiv5_jtag_dp_handler(jtag_dev_t *dev);
 
+/* SW-DP transport, also run on behalf of the remote protocol */
+uint32_t adiv5_swdp_read(ADIv5_DP_t *dp, uint16_t addr);
+uint32_t adiv5_swdp_error(ADIv5_DP_t *dp);
+uint32_t adiv5_swdp_low_access(ADIv5_DP_t *dp, uint8_t RnW,
+                               uint16_t addr, uint32_t value);
+void adiv5_swdp_abort(ADIv5_DP_t *dp, uint32_t abort);
+void adiv5_swdp_write_posted(ADIv5_DP_t *dp, uint16_t addr, uint32_t value);
+void adiv5_swdp_select(ADIv5_DP_t *dp);
+
 void adiv5_mem_read(ADIv5_AP_t *ap, void *dest, uint32_t src, size_t len);
 void adiv5_mem_write(ADIv5_AP_t *ap, uint32_t dest, const void *src, size_t len);
 void adiv5_mem_write_sized(ADIv5_AP_t *ap, uint32_t dest, const void *src,
 						   size_t len, enum align align);
+void adiv5_mem_batch(ADIv5_AP_t *ap, struct target_mem_op *ops, size_t count);
 uint64_t adiv5_ap_read_pidr(ADIv5_AP_t *ap, uint32_t addr);
 #endif
@@ -46,6 +46,25 @@ static uint32_t adiv5_jtagdp_low_access(ADIv5_DP_t *dp, uint8_t RnW,
 
 static void adiv5_jtagdp_abort(ADIv5_DP_t *dp, uint32_t abort);
 
+static void adiv5_jtagdp_write_posted(ADIv5_DP_t *dp, uint16_t addr,
+                                      uint32_t value);
+
+static void adiv5_jtagdp_read_burst(ADIv5_DP_t *dp, uint16_t addr,
+                                    uint32_t *values, size_t count);
+
+/* DR scans queued by write_posted and read_burst. They are shifted as a
+ * sequence, with the IR written once for each run of APACC or DPACC
+ * scans, when a result is needed or before the next single access. */
+#define JTAGDP_BATCH_MAX 64
+#define JTAGDP_SCAN_BYTES 5 /* 35 bits */
+static struct {
+	ADIv5_DP_t *dp;
+	int count;
+	uint8_t ir[JTAGDP_BATCH_MAX];
+	uint8_t din[JTAGDP_BATCH_MAX][JTAGDP_SCAN_BYTES];
+	uint8_t dout[JTAGDP_BATCH_MAX][JTAGDP_SCAN_BYTES];
+} batch;
+
 void adiv5_jtag_dp_handler(jtag_dev_t *dev)
 {
 	ADIv5_DP_t *dp = (void*)calloc(1, sizeof(*dp));
@@ -61,6 +80,8 @@ void adiv5_jtag_dp_handler(jtag_dev_t *dev)
 	dp->error = adiv5_jtagdp_error;
 	dp->low_access = adiv5_jtagdp_low_access;
 	dp->abort = adiv5_jtagdp_abort;
+	dp->write_posted = adiv5_jtagdp_write_posted;
+	dp->read_burst = adiv5_jtagdp_read_burst;
 
 	adiv5_dp_init(dp);
 }
@@ -79,22 +100,117 @@ static uint32_t adiv5_jtagdp_error(ADIv5_DP_t *dp)
 				ADIV5_DP_CTRLSTAT, 0xF0000032) & 0x32;
 }
 
+static uint64_t jtagdp_request(uint8_t RnW, uint16_t addr, uint32_t value)
+{
+	addr &= 0xff;
+	return ((uint64_t)value << 3) | ((addr >> 1) & 0x06) | (RnW?1:0);
+}
+
+/* Shift the queued scans, their results are in after jtagtap_sync().
+ * Returns the number of scans for jtagdp_batch_check(). */
+static int jtagdp_batch_shift(void)
+{
+	int count = batch.count;
+	int first = 0;
+
+	batch.count = 0;
+	while (first < count) {
+		int n = 1;
+		while ((first + n < count) && (batch.ir[first + n] == batch.ir[first]))
+			n++;
+		jtag_dev_write_ir(batch.dp->dev, batch.ir[first]);
+		jtag_dev_shift_dr_seq(batch.dp->dev, batch.dout[first],
+		                      batch.din[first], 35, n);
+		first += n;
+	}
+	return count;
+}
+
+/* With ORUNDETECT set, as in the bursts using the queue, a WAIT leaves
+ * STICKYORUN for the caller to find. */
+static void jtagdp_batch_check(int count)
+{
+	for (int i = 0; i < count; i++) {
+		uint8_t ack = batch.dout[i][0] & 0x07;
+		if ((ack != JTAGDP_ACK_OK) && (ack != JTAGDP_ACK_WAIT))
+			raise_exception(EXCEPTION_ERROR, "JTAG-DP invalid ACK");
+	}
+}
+
+static void jtagdp_batch_flush(void)
+{
+	int count = jtagdp_batch_shift();
+	jtagtap_sync();
+	jtagdp_batch_check(count);
+}
+
+static void jtagdp_batch_add(ADIv5_DP_t *dp, uint8_t RnW, uint16_t addr,
+                             uint32_t value)
+{
+	if ((batch.count == JTAGDP_BATCH_MAX) || (batch.dp != dp))
+		jtagdp_batch_flush();
+	batch.dp = dp;
+	uint64_t request = jtagdp_request(RnW, addr, value);
+	batch.ir[batch.count] = (addr & ADIV5_APnDP) ? IR_APACC : IR_DPACC;
+	for (int i = 0; i < JTAGDP_SCAN_BYTES; i++)
+		batch.din[batch.count][i] = request >> (8 * i);
+	batch.count++;
+}
+
+static uint32_t jtagdp_batch_result(int i)
+{
+	uint64_t response = 0;
+
+	for (int j = 0; j < JTAGDP_SCAN_BYTES; j++)
+		response |= (uint64_t)batch.dout[i][j] << (8 * j);
+	return (uint32_t)(response >> 3);
+}
+
+static void adiv5_jtagdp_write_posted(ADIv5_DP_t *dp, uint16_t addr,
+                                      uint32_t value)
+{
+	jtagdp_batch_add(dp, ADIV5_LOW_WRITE, addr, value);
+}
+
+/* Each APACC read returns the result of the previous one, the last
+ * comes back with RDBUFF */
+static void adiv5_jtagdp_read_burst(ADIv5_DP_t *dp, uint16_t addr,
+                                    uint32_t *values, size_t count)
+{
+	while (count) {
+		int n = MIN(count, JTAGDP_BATCH_MAX - 1);
+		jtagdp_batch_flush();
+		for (int i = 0; i < n; i++)
+			jtagdp_batch_add(dp, ADIV5_LOW_READ, addr, 0);
+		jtagdp_batch_add(dp, ADIV5_LOW_READ, ADIV5_DP_RDBUFF, 0);
+		jtagdp_batch_flush();
+		for (int i = 0; i < n; i++)
+			*values++ = jtagdp_batch_result(i + 1);
+		count -= n;
+	}
+}
+
 static uint32_t adiv5_jtagdp_low_access(ADIv5_DP_t *dp, uint8_t RnW,
 					uint16_t addr, uint32_t value)
 {
 	bool APnDP = addr & ADIV5_APnDP;
-	addr &= 0xff;
 	uint64_t request, response;
 	uint8_t ack;
 	platform_timeout timeout;
 
-	request = ((uint64_t)value << 3) | ((addr >> 1) & 0x06) | (RnW?1:0);
+	/* Queued scans go out with the first attempt */
+	int count = jtagdp_batch_shift();
+	request = jtagdp_request(RnW, addr, value);
 
 	jtag_dev_write_ir(dp->dev, APnDP ? IR_APACC : IR_DPACC);
 
 	platform_timeout_set(&timeout, 2000);
 	do {
-		jtag_dev_shift_dr(dp->dev, (uint8_t*)&response, (uint8_t*)&request, 35);
+		jtag_dev_shift_dr_seq(dp->dev, (uint8_t*)&response,
+		                      (uint8_t*)&request, 35, 1);
+		jtagtap_sync();
+		jtagdp_batch_check(count);
+		count = 0;
 		ack = response & 0x07;
 	} while(!platform_timeout_is_expired(&timeout) && (ack == JTAGDP_ACK_WAIT));
 
@@ -109,6 +225,7 @@ static uint32_t adiv5_jtagdp_low_access(ADIv5_DP_t *dp, uint8_t RnW,
 
 static void adiv5_jtagdp_abort(ADIv5_DP_t *dp, uint32_t abort)
 {
+	jtagdp_batch_flush();
 	uint64_t request = (uint64_t)abort << 3;
 	jtag_dev_write_ir(dp->dev, IR_ABORT);
 	jtag_dev_shift_dr(dp->dev, NULL, (const uint8_t*)&request, 35);
@@ -29,30 +29,136 @@
 #include "target.h"
 #include "target_internal.h"
 
-#define SWDP_ACK_OK    0x01
-#define SWDP_ACK_WAIT  0x02
-#define SWDP_ACK_FAULT 0x04
+/* TARGETSEL of the DP last selected on a multi-drop bus, 0 if none */
+static uint32_t swdp_selected;
+/* IDCODE read back by swdp_tune_check() */
+static uint32_t swdp_tune_idcode;
 
-static uint32_t adiv5_swdp_read(ADIv5_DP_t *dp, uint16_t addr);
+static uint32_t swdp_request(uint8_t RnW, uint16_t addr);
 
-static uint32_t adiv5_swdp_error(ADIv5_DP_t *dp);
+static void swdp_line_reset(void)
+{
+	swdptap_seq_out(0xFFFFFFFF, 32);
+	swdptap_seq_out(0xFFFFFFFF, 18);
+	swdptap_seq_out(0, 16);
+}
+
+/* Read the SW-DP IDCODE register to syncronise */
+/* This could be done with adiv_swdp_low_access(), but this doesn't
+ * allow the ack to be checked here. */
+static bool swdp_read_idcode(uint32_t *idcode)
+{
+	bool parity_error = false;
+	uint8_t ack = swdptap_transfer(0xA5, idcode, &parity_error);
+	return (ack == SWDP_ACK_OK) && !parity_error;
+}
+
+/* Clock tuning check: the IDCODE reads back unchanged after a line reset */
+static bool swdp_tune_check(void)
+{
+	uint32_t idcode;
+
+	swdp_line_reset();
+	return swdp_read_idcode(&idcode) && (idcode == swdp_tune_idcode);
+}
 
-static uint32_t adiv5_swdp_low_access(ADIv5_DP_t *dp, uint8_t RnW,
-				      uint16_t addr, uint32_t value);
+/* Wake up DPs that start in the dormant state, as multi-drop DPs do:
+ * send the SWD ones to dormant first, so all DPs see the selection alert
+ * followed by the SWD activation code. A line reset has to follow. */
+static void swdp_dormant_to_swd(void)
+{
+	/* SWD to dormant: line reset, then 0xE3BC */
+	swdptap_seq_out(0xFFFFFFFF, 32);
+	swdptap_seq_out(0xFFFFFFFF, 24);
+	swdptap_seq_out(0xE3BC, 16);
+	/* Selection alert after at least 8 cycles high */
+	swdptap_seq_out(0xFF, 8);
+	swdptap_seq_out(0x6209F392, 32);
+	swdptap_seq_out(0x86852D95, 32);
+	swdptap_seq_out(0xE3DDAFE9, 32);
+	swdptap_seq_out(0x19BC0EA2, 32);
+	/* 4 cycles low, then the SWD activation code 0x1A */
+	swdptap_seq_out(0x1A << 4, 12);
+}
 
-static void adiv5_swdp_abort(ADIv5_DP_t *dp, uint32_t abort);
+/* Line reset and select one DP of a multi-drop bus. No DP drives the
+ * ACK of the TARGETSEL write, the IDCODE read tells if one answers. */
+static bool swdp_targetsel(uint32_t targetsel, uint32_t *idcode)
+{
+	swdp_line_reset();
+	swdptap_seq_out(swdp_request(ADIV5_LOW_WRITE, ADIV5_DP_TARGETSEL), 8);
+	swdptap_seq_in(3);
+	swdptap_seq_out_parity(targetsel, 32);
+	bool answered = swdp_read_idcode(idcode);
+	swdp_selected = answered ? targetsel : 0;
+	return answered;
+}
 
-int adiv5_swdp_scan(void)
+/* Read a banked DP register of the DP answering on the bus */
+static uint32_t swdp_read_banked(uint8_t bank, uint16_t addr)
 {
-	uint32_t ack;
+	ADIv5_DP_t dp = {0};
 
-	target_list_free();
+	adiv5_swdp_low_access(&dp, ADIV5_LOW_WRITE, ADIV5_DP_SELECT, bank);
+	uint32_t value = adiv5_swdp_low_access(&dp, ADIV5_LOW_READ, addr, 0);
+	adiv5_swdp_low_access(&dp, ADIV5_LOW_WRITE, ADIV5_DP_SELECT,
+	                      ADIV5_DP_BANK0);
+	return value;
+}
+
+/* Switch the bus over to dp when it sits on a multi-drop bus */
+void adiv5_swdp_select(ADIv5_DP_t *dp)
+{
+	uint32_t idcode;
+
+	if (!dp->targetsel || (dp->targetsel == swdp_selected))
+		return;
+	if (!swdp_targetsel(dp->targetsel, &idcode))
+		raise_exception(EXCEPTION_ERROR, "SWDP TARGETSEL failed");
+	/* The DP was deselected, SELECT may have been written meanwhile */
+	adiv5_dp_invalidate(dp);
+}
+
+static void swdp_add_dp(uint32_t idcode, uint32_t targetsel)
+{
 	ADIv5_DP_t *dp = (void*)calloc(1, sizeof(*dp));
 	if (!dp) {			/* calloc failed: heap exhaustion */
 		DEBUG("calloc: failed in %s\n", __func__);
-		return -1;
+		return;
 	}
 
+	dp->idcode = idcode;
+	dp->targetsel = targetsel;
+	dp->dp_read = adiv5_swdp_read;
+	dp->error = adiv5_swdp_error;
+	dp->low_access = adiv5_swdp_low_access;
+	dp->abort = adiv5_swdp_abort;
+	dp->write_posted = adiv5_swdp_write_posted;
+	dp->fault_ack = true;
+#if defined(PLATFORM_HAS_REMOTE_ADIV5)
+	platform_adiv5_dp_defaults(dp);
+#endif
+
+	adiv5_dp_error(dp);
+	adiv5_dp_init(dp);
+}
+
+/* Scan for SW-DPs. With targetid given, the DPs are woken up from the
+ * dormant state and every TINSTANCE is tried for a multi-drop bus, each
+ * DP found gets its own targets. A DPv2 answering without TARGETSEL is
+ * selected by its own TARGETID and TINSTANCE. */
+int adiv5_swdp_scan(uint32_t targetid)
+{
+	uint32_t idcode = 0;
+	int ndps = 0;
+	int first = 0;
+	int last = 15;
+
+	target_list_free();
+	swdp_selected = 0;
+
+	if (frequency_auto)
+		platform_max_frequency_set(FREQUENCY_AUTO_START);
 	if (swdptap_init())
 		return -1;
 
@@ -65,29 +171,59 @@ int adiv5_swdp_scan(void)
 	swdptap_seq_out(0xFFFFFFFF, 18);
 	swdptap_seq_out(0, 16);
 
-	/* Read the SW-DP IDCODE register to syncronise */
-	/* This could be done with adiv_swdp_low_access(), but this doesn't
-	 * allow the ack to be checked here. */
-	swdptap_seq_out(0xA5, 8);
-	ack = swdptap_seq_in(3);
-	if((ack != SWDP_ACK_OK) || swdptap_seq_in_parity(&dp->idcode, 32)) {
-		DEBUG("\n");
-		free(dp);
-		return -1;
+	if (!targetid) {
+		if (!swdp_read_idcode(&idcode)) {
+			DEBUG("\n");
+			return -1;
+		}
+		if (frequency_auto) {
+			swdp_tune_idcode = idcode;
+			platform_max_frequency_tune(swdp_tune_check);
+		}
+		if ((idcode & ADIV5_DP_VERSION_MASK) == ADIV5_DPv2) {
+			targetid = swdp_read_banked(ADIV5_DP_BANK2,
+			                            ADIV5_DP_CTRLSTAT);
+			/* It answered alone, no other instance is on the bus */
+			first = last = (swdp_read_banked(ADIV5_DP_BANK3,
+			                                 ADIV5_DP_CTRLSTAT) &
+			                ADIV5_DP_TINSTANCE_MASK) >>
+				ADIV5_DP_TINSTANCE_SHIFT;
+		}
+	} else {
+		swdp_dormant_to_swd();
 	}
 
-	dp->dp_read = adiv5_swdp_read;
-	dp->error = adiv5_swdp_error;
-	dp->low_access = adiv5_swdp_low_access;
-	dp->abort = adiv5_swdp_abort;
+	for (int i = first; targetid && (i <= last); i++) {
+		uint32_t targetsel = (targetid & ~ADIV5_DP_TINSTANCE_MASK) |
+			(i << ADIV5_DP_TINSTANCE_SHIFT);
+		if (!swdp_targetsel(targetsel, &idcode))
+			continue;
+		/* A DP without multi-drop support answers to any TARGETSEL */
+		uint32_t dlpidr = swdp_read_banked(ADIV5_DP_BANK3,
+		                                   ADIV5_DP_CTRLSTAT);
+		if ((dlpidr & ADIV5_DP_TINSTANCE_MASK) !=
+		    (targetsel & ADIV5_DP_TINSTANCE_MASK))
+			continue;
+		DEBUG("SW-DP multi-drop TARGETSEL 0x%08" PRIx32 "\n", targetsel);
+		swdp_add_dp(idcode, targetsel);
+		ndps++;
+	}
 
-	adiv5_swdp_error(dp);
-	adiv5_dp_init(dp);
+	if (!ndps) {
+		/* Talk to a single DP without TARGETSEL */
+		swdp_selected = 0;
+		swdp_line_reset();
+		if (!swdp_read_idcode(&idcode)) {
+			DEBUG("\n");
+			return -1;
+		}
+		swdp_add_dp(idcode, 0);
+	}
 
 	return target_list?1:0;
 }
 
-static uint32_t adiv5_swdp_read(ADIv5_DP_t *dp, uint16_t addr)
+uint32_t adiv5_swdp_read(ADIv5_DP_t *dp, uint16_t addr)
 {
 	if (addr & ADIV5_APnDP) {
 		adiv5_dp_low_access(dp, ADIV5_LOW_READ, addr, 0);
@@ -98,7 +234,7 @@ static uint32_t adiv5_swdp_read(ADIv5_DP_t *dp, uint16_t addr)
 	}
 }
 
-static uint32_t adiv5_swdp_error(ADIv5_DP_t *dp)
+uint32_t adiv5_swdp_error(ADIv5_DP_t *dp)
 {
 	uint32_t err, clr = 0;
 
@@ -121,17 +257,10 @@ static uint32_t adiv5_swdp_error(ADIv5_DP_t *dp)
 	return err;
 }
 
-static uint32_t adiv5_swdp_low_access(ADIv5_DP_t *dp, uint8_t RnW,
-				      uint16_t addr, uint32_t value)
+static uint32_t swdp_request(uint8_t RnW, uint16_t addr)
 {
 	bool APnDP = addr & ADIV5_APnDP;
-	addr &= 0xff;
 	uint32_t request = 0x81;
-	uint32_t response = 0;
-	uint32_t ack;
-	platform_timeout timeout;
-
-	if(APnDP && dp->fault) return 0;
 
 	if(APnDP) request ^= 0x22;
 	if(RnW)   request ^= 0x24;
@@ -140,29 +269,26 @@ static uint32_t adiv5_swdp_low_access(ADIv5_DP_t *dp, uint8_t RnW,
 	request |= (addr << 1) & 0x18;
 	if((addr == 4) || (addr == 8))
 		request ^= 0x20;
+	return request;
+}
 
-	platform_timeout_set(&timeout, 2000);
-	do {
-		swdptap_seq_out(request, 8);
-		ack = swdptap_seq_in(3);
-	} while (ack == SWDP_ACK_WAIT && !platform_timeout_is_expired(&timeout));
-
-	if (ack == SWDP_ACK_WAIT)
-		raise_exception(EXCEPTION_TIMEOUT, "SWDP ACK timeout");
-
-	if(ack == SWDP_ACK_FAULT) {
-		dp->fault = 1;
-		return 0;
-	}
+uint8_t swdptap_transfer(uint8_t request, uint32_t *data, bool *parity_error)
+{
+	uint8_t ack;
 
-	if(ack != SWDP_ACK_OK)
-		raise_exception(EXCEPTION_ERROR, "SWDP invalid ACK");
+#if defined(PLATFORM_HAS_SWDPTAP_TRANSFER)
+	if (platform_swdptap_transfer(request, data, &ack, parity_error))
+		return ack;
+#endif
+	swdptap_seq_out(request, 8);
+	ack = swdptap_seq_in(3);
+	if (ack != SWDP_ACK_OK)
+		return ack;
 
-	if(RnW) {
-		if(swdptap_seq_in_parity(&response, 32))  /* Give up on parity error */
-			raise_exception(EXCEPTION_ERROR, "SWDP Parity error");
+	if (request & 0x04) {
+		*parity_error = swdptap_seq_in_parity(data, 32);
 	} else {
-		swdptap_seq_out_parity(value, 32);
+		swdptap_seq_out_parity(*data, 32);
 		/* RM0377 Rev. 8 Chapter 27.5.4 for STM32L0x1 states:
 		 * Because of the asynchronous clock domains SWCLK and HCLK,
 		 * two extra SWCLK cycles are needed after a write transaction
@@ -175,11 +301,57 @@ static uint32_t adiv5_swdp_low_access(ADIv5_DP_t *dp, uint8_t RnW,
 		 */
 		swdptap_seq_out(0, 2);
 	}
+	return ack;
+}
 
-	return response;
+uint32_t adiv5_swdp_low_access(ADIv5_DP_t *dp, uint8_t RnW,
+				      uint16_t addr, uint32_t value)
+{
+	bool APnDP = addr & ADIV5_APnDP;
+	uint32_t request = swdp_request(RnW, addr);
+	uint32_t response;
+	bool parity_error = false;
+	uint8_t ack;
+	platform_timeout timeout;
+
+	adiv5_swdp_select(dp);
+	if(APnDP && dp->fault) return 0;
+
+	platform_timeout_set(&timeout, 2000);
+	do {
+		response = value;
+		ack = swdptap_transfer(request, &response, &parity_error);
+	} while (ack == SWDP_ACK_WAIT && !platform_timeout_is_expired(&timeout));
+
+	if (ack == SWDP_ACK_WAIT)
+		raise_exception(EXCEPTION_TIMEOUT, "SWDP ACK timeout");
+
+	if(ack == SWDP_ACK_FAULT) {
+		dp->fault = 1;
+		return 0;
+	}
+
+	if(ack != SWDP_ACK_OK)
+		raise_exception(EXCEPTION_ERROR, "SWDP invalid ACK");
+
+	if(parity_error)  /* Give up on parity error */
+		raise_exception(EXCEPTION_ERROR, "SWDP Parity error");
+
+	return RnW ? response : 0;
+}
+
+/* Write without looking at the ACK, for bursts run with ORUNDETECT set.
+ * The data phase follows a WAIT or FAULT ACK as well, the DP flags these
+ * as STICKYORUN or STICKYERR for the check at the end of the burst. */
+void adiv5_swdp_write_posted(ADIv5_DP_t *dp, uint16_t addr, uint32_t value)
+{
+	adiv5_swdp_select(dp);
+	swdptap_seq_out(swdp_request(ADIV5_LOW_WRITE, addr), 8);
+	swdptap_seq_in(3);
+	swdptap_seq_out_parity(value, 32);
 }
 
-static void adiv5_swdp_abort(ADIv5_DP_t *dp, uint32_t abort)
+void adiv5_swdp_abort(ADIv5_DP_t *dp, uint32_t abort)
 {
 	adiv5_dp_write(dp, ADIV5_DP_ABORT, abort);
 }
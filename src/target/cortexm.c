@@ -231,10 +231,25 @@ static void cortexm_mem_write(target *t, target_addr dest, const void *src, size
 	adiv5_mem_write(cortexm_ap(t), dest, src, len);
 }
 
+static uint32_t cortexm_mem_crc32(target *t, target_addr base, size_t len)
+{
+	ADIv5_AP_t *ap = cortexm_ap(t);
+	cortexm_cache_clean(t, base, len, false);
+	return ap->dp->mem_crc32(ap, base, len);
+}
+
+static void cortexm_mem_access_batch(target *t, struct target_mem_op *ops,
+                                     size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		cortexm_cache_clean(t, ops[i].addr, ops[i].size, ops[i].write);
+	adiv5_mem_batch(cortexm_ap(t), ops, count);
+}
+
 static bool cortexm_check_error(target *t)
 {
 	ADIv5_AP_t *ap = cortexm_ap(t);
-	return adiv5_dp_error(ap->dp) != 0;
+	return adiv5_dp_check_error(ap->dp);
 }
 
 static void cortexm_priv_free(void *priv)
@@ -263,6 +278,28 @@ static bool cortexm_forced_halt(target *t)
 	return true;
 }
 
+static bool (* const cortexm_probes[])(target *t) = {
+	stm32f1_probe,
+	stm32f4_probe,
+	stm32h7_probe,
+	stm32l0_probe,   /* STM32L0xx & STM32L1xx */
+	stm32l4_probe,
+	lpc11xx_probe,
+	lpc15xx_probe,
+	lpc43xx_probe,
+	sam3x_probe,
+	sam4l_probe,
+	nrf51_probe,
+	samd_probe,
+	samx5x_probe,
+	lmi_probe,
+	kinetis_probe,
+	efm32_probe,
+	msp432_probe,
+	ke04_probe,
+	lpc17xx_probe,
+};
+
 bool cortexm_probe(ADIv5_AP_t *ap, bool forced)
 {
 	target *t;
@@ -287,6 +324,10 @@ bool cortexm_probe(ADIv5_AP_t *ap, bool forced)
 	t->check_error = cortexm_check_error;
 	t->mem_read = cortexm_mem_read;
 	t->mem_write = cortexm_mem_write;
+	if (ap->dp->mem_crc32)
+		t->mem_crc32 = cortexm_mem_crc32;
+	if (ap->dp->mem_batch)
+		t->mem_access_batch = cortexm_mem_access_batch;
 
 	t->driver = cortexm_driver_str;
 	switch (identity) {
@@ -356,29 +397,21 @@ bool cortexm_probe(ADIv5_AP_t *ap, bool forced)
 		if (!cortexm_forced_halt(t))
 			return false;
 
-#define PROBE(x) \
-	do { if ((x)(t)) {target_halt_resume(t, 0); return true;} else target_check_error(t); } while (0)
-
-	PROBE(stm32f1_probe);
-	PROBE(stm32f4_probe);
-	PROBE(stm32h7_probe);
-	PROBE(stm32l0_probe);   /* STM32L0xx & STM32L1xx */
-	PROBE(stm32l4_probe);
-	PROBE(lpc11xx_probe);
-	PROBE(lpc15xx_probe);
-	PROBE(lpc43xx_probe);
-	PROBE(sam3x_probe);
-	PROBE(sam4l_probe);
-	PROBE(nrf51_probe);
-	PROBE(samd_probe);
-	PROBE(samx5x_probe);
-	PROBE(lmi_probe);
-	PROBE(kinetis_probe);
-	PROBE(efm32_probe);
-	PROBE(msp432_probe);
-	PROBE(ke04_probe);
-	PROBE(lpc17xx_probe);
-#undef PROBE
+	/* Try the driver that matched on this AP before first */
+	const unsigned nprobes = sizeof(cortexm_probes) / sizeof(cortexm_probes[0]);
+	unsigned hint = (ap->probe_hint <= nprobes) ? ap->probe_hint : 0;
+	for (unsigned i = 0; i <= nprobes; i++) {
+		unsigned n = i ? i : hint;
+		if (!n || (i && (n == hint)))
+			continue;
+		if (cortexm_probes[n - 1](t)) {
+			ap->probe_hint = n;
+			target_halt_resume(t, 0);
+			return true;
+		}
+		target_check_error(t);
+	}
+	ap->probe_hint = 0;
 
 	return true;
 }
@@ -390,7 +423,7 @@ bool cortexm_attach(target *t)
 	uint32_t r;
 
 	/* Clear any pending fault condition */
-	target_check_error(t);
+	adiv5_dp_error(cortexm_ap(t)->dp);
 
 	target_halt_request(t);
 	if (!cortexm_forced_halt(t))
@@ -474,7 +507,7 @@ static void cortexm_regs_read(target *t, void *data)
 
 	/* Map the banked data registers (0x10-0x1c) to the
 	 * debug registers DHCSR, DCRSR, DCRDR and DEMCR respectively */
-	adiv5_dp_low_access(ap->dp, ADIV5_LOW_WRITE, ADIV5_AP_TAR, CORTEXM_DHCSR);
+	adiv5_ap_write(ap, ADIV5_AP_TAR, CORTEXM_DHCSR);
 
 	/* Walk the regnum_cortex_m array, reading the registers it
 	 * calls out. */
@@ -518,7 +551,7 @@ static void cortexm_regs_write(target *t, const void *data)
 
 	/* Map the banked data registers (0x10-0x1c) to the
 	 * debug registers DHCSR, DCRSR, DCRDR and DEMCR respectively */
-	adiv5_dp_low_access(ap->dp, ADIV5_LOW_WRITE, ADIV5_AP_TAR, CORTEXM_DHCSR);
+	adiv5_ap_write(ap, ADIV5_AP_TAR, CORTEXM_DHCSR);
 
 	/* Walk the regnum_cortex_m array, writing the registers it
 	 * calls out. */
@@ -621,6 +654,8 @@ static void cortexm_reset(target *t)
 	if (t->extended_reset != NULL) {
 		t->extended_reset(t);
 	}
+	/* A reset may take the AP registers with it */
+	adiv5_dp_invalidate(cortexm_ap(t)->dp);
 	/* Wait for CORTEXM_DHCSR_S_RESET_ST to read 0, meaning reset released.*/
 	platform_timeout_set(&to, 1000);
 	while ((target_mem_read32(t, CORTEXM_DHCSR) & CORTEXM_DHCSR_S_RESET_ST) &&
@@ -635,7 +670,7 @@ static void cortexm_reset(target *t)
 	/* Reset DFSR flags */
 	target_mem_write32(t, CORTEXM_DFSR, CORTEXM_DFSR_RESETALL);
 	/* Make sure we ignore any initial DAP error */
-	target_check_error(t);
+	adiv5_dp_error(cortexm_ap(t)->dp);
 }
 
 static void cortexm_halt_request(target *t)
@@ -654,13 +689,24 @@ static void cortexm_halt_request(target *t)
 static enum target_halt_reason cortexm_halt_poll(target *t, target_addr *watch)
 {
 	struct cortexm_priv *priv = t->priv;
+	ADIv5_AP_t *ap = cortexm_ap(t);
+	/* DFSR comes along, it only matters once halted */
+	struct target_mem_op poll[] = {
+		{ .addr = CORTEXM_DHCSR, .size = 4 },
+		{ .addr = CORTEXM_DFSR, .size = 4 },
+	};
 
-	volatile uint32_t dhcsr = 0;
+	volatile bool running = false;
 	volatile struct exception e;
 	TRY_CATCH (e, EXCEPTION_ALL) {
+		/* Let the transport wait for the halt where it can */
+		if (ap->dp->mem_watch)
+			running = !ap->dp->mem_watch(ap, CORTEXM_DHCSR,
+			                             CORTEXM_DHCSR_S_HALT);
 		/* If this times out because the target is in WFI then
 		 * the target is still running. */
-		dhcsr = target_mem_read32(t, CORTEXM_DHCSR);
+		if (!running)
+			target_mem_access_batch(t, poll, sizeof(poll) / sizeof(poll[0]));
 	}
 	switch (e.type) {
 	case EXCEPTION_ERROR:
@@ -672,22 +718,29 @@ static enum target_halt_reason cortexm_halt_poll(target *t, target_addr *watch)
 		return TARGET_HALT_RUNNING;
 	}
 
-	if (!(dhcsr & CORTEXM_DHCSR_S_HALT))
+	if (running || !(poll[0].value & CORTEXM_DHCSR_S_HALT))
 		return TARGET_HALT_RUNNING;
 
-	/* We've halted.  Let's find out why. */
-	uint32_t dfsr = target_mem_read32(t, CORTEXM_DFSR);
-	target_mem_write32(t, CORTEXM_DFSR, dfsr); /* write back to reset */
+	/* We've halted.  Let's find out why. Reset DFSR by writing it
+	 * back, and fetch the PC along if we stopped on a breakpoint. */
+	uint32_t dfsr = poll[1].value;
+	bool on_bkpt = dfsr & (CORTEXM_DFSR_BKPT);
+	struct target_mem_op halted[] = {
+		{ .addr = CORTEXM_DFSR, .value = dfsr, .size = 4, .write = true },
+		{ .addr = CORTEXM_DCRSR, .value = 0x0F, .size = 4, .write = true },
+		{ .addr = CORTEXM_DCRDR, .size = 4 },
+	};
+	target_mem_access_batch(t, halted, on_bkpt ? 3 : 1);
 
 	if ((dfsr & CORTEXM_DFSR_VCATCH) && cortexm_fault_unwind(t))
 		return TARGET_HALT_FAULT;
 
 	/* Remember if we stopped on a breakpoint */
-	priv->on_bkpt = dfsr & (CORTEXM_DFSR_BKPT);
+	priv->on_bkpt = on_bkpt;
 	if (priv->on_bkpt) {
 		/* If we've hit a programmed breakpoint, check for semihosting
 		 * call. */
-		uint32_t pc = cortexm_pc_read(t);
+		uint32_t pc = halted[2].value;
 		uint16_t bkpt_instr;
 		bkpt_instr = target_mem_read16(t, pc);
 		if (bkpt_instr == 0xBEAB) {
@@ -947,19 +1000,26 @@ static int cortexm_breakwatch_clear(target *t, struct breakwatch *bw)
 static target_addr cortexm_check_watch(target *t)
 {
 	struct cortexm_priv *priv = t->priv;
-	unsigned i;
+	struct target_mem_op ops[2 * CORTEXM_MAX_WATCHPOINTS];
+	unsigned i, count = 0;
 
-	for(i = 0; i < priv->hw_watchpoint_max; i++)
-		/* if SET and MATCHED then break */
-		if(priv->hw_watchpoint[i] &&
-		   (target_mem_read32(t, CORTEXM_DWT_FUNC(i)) &
-					CORTEXM_DWT_FUNC_MATCHED))
-			break;
+	/* Fetch the function and comparator of all set watchpoints at once */
+	for (i = 0; i < priv->hw_watchpoint_max; i++) {
+		if (!priv->hw_watchpoint[i])
+			continue;
+		ops[count++] = (struct target_mem_op){
+			.addr = CORTEXM_DWT_FUNC(i), .size = 4 };
+		ops[count++] = (struct target_mem_op){
+			.addr = CORTEXM_DWT_COMP(i), .size = 4 };
+	}
+	target_mem_access_batch(t, ops, count);
 
-	if (i == priv->hw_watchpoint_max)
-		return 0;
+	for (i = 0; i < count; i += 2)
+		/* if SET and MATCHED then break */
+		if (ops[i].value & CORTEXM_DWT_FUNC_MATCHED)
+			return ops[i + 1].value;
 
-	return target_mem_read32(t, CORTEXM_DWT_COMP(i));
+	return 0;
 }
 
 static bool cortexm_vector_catch(target *t, int argc, char *argv[])
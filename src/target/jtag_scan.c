@@ -36,6 +36,41 @@ int jtag_dev_count;
 /* bucket of ones for don't care TDI */
 static const uint8_t ones[] = "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF";
 
+/* Bits captured by the scans below. The IR scan shifts out at most
+ * JTAG_SCAN_IR_BITS, the IDCODE scan 32 bits for each device. */
+#define JTAG_SCAN_IR_BITS ((JTAG_MAX_DEVS + 1) * (JTAG_MAX_IR_LEN + 1) + 1)
+#define JTAG_SCAN_TDO_BYTES ((JTAG_MAX_DEVS + 1) * 4 + 1)
+
+/* Shift ticks ones in the current Shift state, capturing TDO to tdo */
+static void jtag_scan_ones(uint8_t *tdo, int ticks)
+{
+	memset(tdo, 0xff, JTAG_SCAN_TDO_BYTES);
+	jtagtap_tdi_tdo_seq_defer(tdo, 0, tdo, ticks);
+	jtagtap_sync();
+}
+
+static bool jtag_scan_bit(const uint8_t *tdo, int bit)
+{
+	return tdo[bit / 8] & (1 << (bit % 8));
+}
+
+/* IDCODE scan read back by jtag_tune_check() */
+static int jtag_tune_bits;
+static uint8_t jtag_tune_tdo[JTAG_SCAN_TDO_BYTES];
+
+/* Clock tuning check: the IDCODEs read back unchanged after a reset */
+static bool jtag_tune_check(void)
+{
+	uint8_t tdo[JTAG_SCAN_TDO_BYTES];
+
+	jtagtap_reset();
+	jtagtap_shift_dr();
+	jtag_scan_ones(tdo, jtag_tune_bits);
+	jtagtap_tdi_seq(1, ones, 1);
+	jtagtap_return_idle();
+	return !memcmp(tdo, jtag_tune_tdo, (jtag_tune_bits + 7) / 8);
+}
+
 /* Scan JTAG chain for devices, store IR length and IDCODE (if present).
  * Reset TAP state machine.
  * Select Shift-IR state.
@@ -57,6 +92,7 @@ int jtag_scan(const uint8_t *irlens)
 {
 	int i;
 	uint32_t j;
+	uint8_t tdo[JTAG_SCAN_TDO_BYTES];
 
 	target_list_free();
 
@@ -67,6 +103,8 @@ int jtag_scan(const uint8_t *irlens)
 	 * in SW-DP mode.
 	 */
 	DEBUG("Resetting TAP\n");
+	if (frequency_auto)
+		platform_max_frequency_set(FREQUENCY_AUTO_START);
 	jtagtap_init();
 	jtagtap_reset();
 
@@ -75,16 +113,13 @@ int jtag_scan(const uint8_t *irlens)
 		DEBUG("Change state to Shift-IR\n");
 		jtagtap_shift_ir();
 		j = 0;
+		uint32_t irout[JTAG_MAX_DEVS + 1] = {0};
 		while((jtag_dev_count <= JTAG_MAX_DEVS) &&
 		      (jtag_devs[jtag_dev_count].ir_len <= JTAG_MAX_IR_LEN)) {
-			uint32_t irout;
 			if(*irlens == 0)
 				break;
-			jtagtap_tdi_tdo_seq((uint8_t*)&irout, 0, ones, *irlens);
-			if (!(irout & 1)) {
-				DEBUG("check failed: IR[0] != 1\n");
-				return -1;
-			}
+			jtagtap_tdi_tdo_seq_defer((uint8_t*)&irout[jtag_dev_count], 0,
+			                          ones, *irlens);
 			jtag_devs[jtag_dev_count].ir_len = *irlens;
 			jtag_devs[jtag_dev_count].ir_prescan = j;
 			jtag_devs[jtag_dev_count].dev = jtag_dev_count;
@@ -92,12 +127,21 @@ int jtag_scan(const uint8_t *irlens)
 			irlens++;
 			jtag_dev_count++;
 		}
+		jtagtap_sync();
+		for (i = 0; i < jtag_dev_count; i++) {
+			if (!(irout[i] & 1)) {
+				DEBUG("check failed: IR[0] != 1\n");
+				return -1;
+			}
+		}
 	} else {
 		DEBUG("Change state to Shift-IR\n");
 		jtagtap_shift_ir();
 
 		DEBUG("Scanning out IRs\n");
-		if(!jtagtap_next(0, 1)) {
+		/* Shift out all IRs at once, then walk the captured bits */
+		jtag_scan_ones(tdo, JTAG_SCAN_IR_BITS);
+		if(!jtag_scan_bit(tdo, 0)) {
 			DEBUG("jtag_scan: Sanity check failed: IR[0] shifted out as 0\n");
 			jtag_dev_count = -1;
 			return -1; /* must be 1 */
@@ -105,7 +149,7 @@ int jtag_scan(const uint8_t *irlens)
 		jtag_devs[0].ir_len = 1; j = 1;
 		while((jtag_dev_count <= JTAG_MAX_DEVS) &&
 		      (jtag_devs[jtag_dev_count].ir_len <= JTAG_MAX_IR_LEN)) {
-			if(jtagtap_next(0, 1)) {
+			if(jtag_scan_bit(tdo, j)) {
 				if(jtag_devs[jtag_dev_count].ir_len == 1) break;
 				jtag_devs[++jtag_dev_count].ir_len = 1;
 				jtag_devs[jtag_dev_count].ir_prescan = j;
@@ -126,7 +170,7 @@ int jtag_scan(const uint8_t *irlens)
 	}
 
 	DEBUG("Return to Run-Test/Idle\n");
-	jtagtap_next(1, 1);
+	jtagtap_tdi_seq(1, ones, 1);
 	jtagtap_return_idle();
 
 	/* All devices should be in BYPASS now */
@@ -134,7 +178,8 @@ int jtag_scan(const uint8_t *irlens)
 	/* Count device on chain */
 	DEBUG("Change state to Shift-DR\n");
 	jtagtap_shift_dr();
-	for(i = 0; (jtagtap_next(0, 1) == 0) && (i <= jtag_dev_count); i++)
+	jtag_scan_ones(tdo, jtag_dev_count + 2);
+	for(i = 0; !jtag_scan_bit(tdo, i) && (i <= jtag_dev_count); i++)
 		jtag_devs[i].dr_postscan = jtag_dev_count - i - 1;
 
 	if(i != jtag_dev_count) {
@@ -145,7 +190,7 @@ int jtag_scan(const uint8_t *irlens)
 	}
 
 	DEBUG("Return to Run-Test/Idle\n");
-	jtagtap_next(1, 1);
+	jtagtap_tdi_seq(1, ones, 1);
 	jtagtap_return_idle();
 	if(!jtag_dev_count) {
 		return 0;
@@ -159,17 +204,25 @@ int jtag_scan(const uint8_t *irlens)
 	/* Reset jtagtap: should take all devs to IDCODE */
 	jtagtap_reset();
 	jtagtap_shift_dr();
+	jtag_scan_ones(tdo, jtag_dev_count * 32);
+	int bit = 0;
 	for(i = 0; i < jtag_dev_count; i++) {
-		if(!jtagtap_next(0, 1)) continue;
+		if(!jtag_scan_bit(tdo, bit++)) continue;
 		jtag_devs[i].idcode = 1;
 		for(j = 2; j; j <<= 1)
-			if(jtagtap_next(0, 1)) jtag_devs[i].idcode |= j;
+			if(jtag_scan_bit(tdo, bit++)) jtag_devs[i].idcode |= j;
 
 	}
 	DEBUG("Return to Run-Test/Idle\n");
-	jtagtap_next(1, 1);
+	jtagtap_tdi_seq(1, ones, 1);
 	jtagtap_return_idle();
 
+	if (frequency_auto) {
+		jtag_tune_bits = jtag_dev_count * 32;
+		memcpy(jtag_tune_tdo, tdo, sizeof(tdo));
+		platform_max_frequency_tune(jtag_tune_check);
+	}
+
 	/* Check for known devices and handle accordingly */
 	for(i = 0; i < jtag_dev_count; i++)
 		for(j = 0; dev_descr[j].idcode; j++)
@@ -213,3 +266,33 @@ void jtag_dev_shift_dr(jtag_dev_t *d, uint8_t *dout, const uint8_t *din, int tic
 	jtagtap_return_idle();
 }
 
+/* Shift count DR scans of ticks bits each, as jtag_dev_shift_dr() would
+ * one by one. din and dout hold the scans at a stride of (ticks + 7) / 8
+ * bytes. Platforms with a slow link to the TAP run the whole sequence
+ * in one go. dout is only valid after jtagtap_sync(). */
+void jtag_dev_shift_dr_seq(jtag_dev_t *d, uint8_t *dout, const uint8_t *din,
+                           int ticks, int count)
+{
+	int bytes = (ticks + 7) / 8;
+
+#if defined(PLATFORM_HAS_JTAG_DR_SEQ)
+	if (platform_jtag_dr_seq(dout, din, ticks, count, d->dr_prescan,
+	                         d->dr_postscan))
+		return;
+#endif
+	jtagtap_shift_dr();
+	for (int i = 0; i < count; i++) {
+		jtagtap_tdi_seq(0, ones, d->dr_prescan);
+		if(dout)
+			jtagtap_tdi_tdo_seq_defer(dout + i * bytes, d->dr_postscan?0:1,
+			                          din + i * bytes, ticks);
+		else
+			jtagtap_tdi_seq(d->dr_postscan?0:1, din + i * bytes, ticks);
+		jtagtap_tdi_seq(1, ones, d->dr_postscan);
+		/* Exit1-DR, Update-DR, Run-Test/Idle and on to Shift-DR */
+		if (i + 1 < count)
+			jtagtap_tms_seq(0x05, 5);
+	}
+	jtagtap_return_idle();
+}
+
@@ -49,6 +49,8 @@ extern int jtag_dev_count;
 
 void jtag_dev_write_ir(jtag_dev_t *dev, uint32_t ir);
 void jtag_dev_shift_dr(jtag_dev_t *dev, uint8_t *dout, const uint8_t *din, int ticks);
+void jtag_dev_shift_dr_seq(jtag_dev_t *dev, uint8_t *dout, const uint8_t *din,
+                           int ticks, int count);
 
 #endif
 
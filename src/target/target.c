@@ -517,6 +517,40 @@ void target_mem_write8(target *t, uint32_t addr, uint8_t value)
 	t->mem_write(t, addr, &value, sizeof(value));
 }
 
+/* Run a list of reads and writes in order, in one go where the target
+ * can. Values read are returned in the ops, errors are left to
+ * target_check_error() as for the accesses above. */
+void target_mem_access_batch(target *t, struct target_mem_op *ops, size_t count)
+{
+	if (t->mem_access_batch) {
+		t->mem_access_batch(t, ops, count);
+		return;
+	}
+	for (size_t i = 0; i < count; i++) {
+		struct target_mem_op *op = &ops[i];
+		switch (op->size) {
+		case 1:
+			if (op->write)
+				target_mem_write8(t, op->addr, op->value);
+			else
+				op->value = target_mem_read8(t, op->addr);
+			break;
+		case 2:
+			if (op->write)
+				target_mem_write16(t, op->addr, op->value);
+			else
+				op->value = target_mem_read16(t, op->addr);
+			break;
+		default:
+			if (op->write)
+				target_mem_write32(t, op->addr, op->value);
+			else
+				op->value = target_mem_read32(t, op->addr);
+			break;
+		}
+	}
+}
+
 void target_command_help(target *t)
 {
 	for (struct target_command_s *tc = t->commands; tc; tc = tc->next) {
@@ -72,6 +72,14 @@ struct breakwatch {
 	uint32_t reserved[4]; /* for use by the implementing driver */
 };
 
+/* One access of target_mem_access_batch() */
+struct target_mem_op {
+	target_addr addr;
+	uint32_t value; /* Value to write, or value read */
+	uint8_t size;   /* 1, 2 or 4 bytes */
+	bool write;
+};
+
 struct target_s {
 	bool attached;
 	struct target_controller *tc;
@@ -86,6 +94,11 @@ struct target_s {
 	                 size_t len);
 	void (*mem_write)(target *t, target_addr dest,
 	                  const void *src, size_t len);
+	/* Optional, CRC-32 computed close to the target, see crc32.h */
+	uint32_t (*mem_crc32)(target *t, target_addr base, size_t len);
+	/* Optional, a list of single accesses run by the transport in one go */
+	void (*mem_access_batch)(target *t, struct target_mem_op *ops,
+	                         size_t count);
 
 	/* Register access functions */
 	size_t regs_size;
@@ -139,6 +152,7 @@ void target_mem_write32(target *t, uint32_t addr, uint32_t value);
 void target_mem_write16(target *t, uint32_t addr, uint16_t value);
 void target_mem_write8(target *t, uint32_t addr, uint8_t value);
 bool target_check_error(target *t);
+void target_mem_access_batch(target *t, struct target_mem_op *ops, size_t count);
 
 /* Access to host controller interface */
 void tc_printf(target *t, const char *fmt, ...);